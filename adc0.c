@@ -75,3 +75,22 @@ int16_t readAdc0Ss3()
     while (ADC0_SSFSTAT3_R & ADC_SSFSTAT3_EMPTY);
     return ADC0_SSFIFO3_R;                           // get single result from the FIFO
 }
+
+// Set SS3 trigger source (one of ADC_EMUX_EM3_xxx)
+void setAdc0Ss3Trigger(uint32_t trigger)
+{
+    ADC0_ACTSS_R &= ~ADC_ACTSS_ASEN3;                // disable sample sequencer 3 (SS3) for programming
+    ADC0_EMUX_R &= ~ADC_EMUX_EM3_M;                  // clear SS3 trigger select
+    ADC0_EMUX_R |= trigger;                          // select new SS3 trigger
+    ADC0_ACTSS_R |= ADC_ACTSS_ASEN3;                 // enable SS3 for operation
+}
+
+// Raise the ADC0 SS3 interrupt after every sample
+void enableAdc0Ss3Interrupt()
+{
+    ADC0_ACTSS_R &= ~ADC_ACTSS_ASEN3;                // disable sample sequencer 3 (SS3) for programming
+    ADC0_SSCTL3_R = ADC_SSCTL3_END0 | ADC_SSCTL3_IE0; // interrupt on the single sample
+    ADC0_IM_R |= ADC_IM_MASK3;                       // pass SS3 interrupt to the NVIC
+    ADC0_ACTSS_R |= ADC_ACTSS_ASEN3;                 // enable SS3 for operation
+    NVIC_EN0_R |= 1 << (INT_ADC0SS3 - 16);           // turn-on interrupt 33 (ADC0SS3)
+}
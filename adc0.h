@@ -27,5 +27,7 @@ void initAdc0Ss3();
 void setAdc0Ss3Log2AverageCount(uint8_t log2AverageCount);
 void setAdc0Ss3Mux(uint8_t input);
 int16_t readAdc0Ss3();
+void setAdc0Ss3Trigger(uint32_t trigger);
+void enableAdc0Ss3Interrupt();
 
 #endif
@@ -0,0 +1,197 @@
+// Alarm Engine Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// Alarms are described by a table of rules, each watching one vital. A new
+// sample only evaluates the rules of its own vital, which sit next to each
+// other in the table, so the cost per sample does not grow with the table.
+// A rule trips past its limit and clears only once the value is back past
+// the limit by the hysteresis, and either change must hold for the
+// debounce time before it is taken and reported through the callback.
+// Times are free-running clock counts, compared by unsigned subtraction.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "alarm.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initAlarms(ALARMS *alarms, const ALARM_RULE *rules, uint8_t ruleCount,
+                uint32_t clocksPerSecond, ALARM_CALLBACK callback,
+                uint32_t time) {
+    uint8_t i, v;
+    alarms->rules = rules;
+    alarms->ruleCount = ruleCount;
+    alarms->clocksPerSecond = clocksPerSecond;
+    alarms->callback = callback;
+    alarms->active = 0;
+    for (v = 0; v < ALARM_MAX_VITALS; v++) {
+        alarms->vital[v].value = 0;
+        alarms->vital[v].time = time;  // loss is timed from here
+        alarms->vital[v].seen = false;
+        alarms->vital[v].first = 0;
+        alarms->vital[v].count = 0;
+    }
+    for (i = 0; i < ruleCount; i++) {
+        alarms->state[i].limit = rules[i].limit;
+        alarms->state[i].since = time;
+        alarms->state[i].changing = false;
+        alarms->state[i].active = false;
+        v = rules[i].vital;
+        if (alarms->vital[v].count == 0) {
+            alarms->vital[v].first = i;
+        }
+        alarms->vital[v].count++;
+    }
+}
+
+void setAlarmLimit(ALARMS *alarms, uint8_t rule, int32_t limit) {
+    alarms->state[rule].limit = limit;
+}
+
+// trip and clear are the raw conditions, the debounce decides when the
+// rule follows them
+void updateAlarmRule(ALARMS *alarms, uint8_t rule, bool trip, bool clear,
+                     uint32_t time) {
+    ALARM_STATE *state = &alarms->state[rule];
+    bool want = state->active ? !clear : trip;
+    if (want == state->active) {
+        state->changing = false;
+        return;
+    }
+    if (!state->changing) {
+        state->changing = true;
+        state->since = time;
+    }
+    if (time - state->since >= alarms->rules[rule].debounce) {
+        state->changing = false;
+        state->active = want;
+        if (want) {
+            alarms->active |= 1u << rule;
+        } else {
+            alarms->active &= ~(1u << rule);
+        }
+        if (alarms->callback) {
+            alarms->callback(rule, want,
+                             alarms->vital[alarms->rules[rule].vital].value,
+                             time);
+        }
+    }
+}
+
+// Evaluate the rules of one vital on its new sample (Q16.16)
+void addAlarmSample(ALARMS *alarms, uint8_t vital, int32_t value,
+                    uint32_t time) {
+    ALARM_VITAL *v = &alarms->vital[vital];
+    const ALARM_RULE *rule;
+    int32_t limit, hysteresis, rate = 0;
+    int64_t change;
+    uint32_t elapsed = time - v->time;
+    bool haveRate = v->seen && elapsed > 0;
+    uint8_t i;
+    if (haveRate) {
+        change = ((int64_t)value - v->value) * alarms->clocksPerSecond /
+                 elapsed;
+        if (change < 0) {
+            change = -change;
+        }
+        rate = change > INT32_MAX ? INT32_MAX : change;
+    }
+    v->value = value;
+    v->time = time;
+    v->seen = true;
+    for (i = v->first; i < v->first + v->count; i++) {
+        rule = &alarms->rules[i];
+        limit = alarms->state[i].limit;
+        hysteresis = rule->hysteresis;
+        // clear points in 64 bits, a limit near the Q16.16 range would
+        // overflow with the hysteresis added
+        switch (rule->kind) {
+            case ALARM_LOW:
+                updateAlarmRule(alarms, i, value < limit,
+                                value > (int64_t)limit + hysteresis, time);
+                break;
+            case ALARM_HIGH:
+                updateAlarmRule(alarms, i, value > limit,
+                                value < (int64_t)limit - hysteresis, time);
+                break;
+            case ALARM_RATE:
+                if (haveRate) {
+                    updateAlarmRule(alarms, i, rate > limit,
+                                    rate < (int64_t)limit - hysteresis,
+                                    time);
+                }
+                break;
+            case ALARM_LOSS:
+                updateAlarmRule(alarms, i, false, true, time);
+                break;
+        }
+    }
+}
+
+// Loss rules have no sample to run on, call this periodically. A lost
+// vital stays lost until its next sample clears the rule, and the age of a
+// silent vital is held at ALARM_MAX_AGE so it never wraps back under the
+// limit. Held vitals start over: no rate across the gap, and no debounce
+// left pending from before it.
+void checkAlarmLoss(ALARMS *alarms, uint32_t time) {
+    ALARM_VITAL *v;
+    uint8_t i, n;
+    bool lost;
+    for (n = 0; n < ALARM_MAX_VITALS; n++) {
+        v = &alarms->vital[n];
+        if (time - v->time > ALARM_MAX_AGE) {
+            v->time = time - ALARM_MAX_AGE;
+            v->seen = false;
+            for (i = v->first; i < v->first + v->count; i++) {
+                if (alarms->rules[i].kind != ALARM_LOSS) {
+                    alarms->state[i].changing = false;
+                }
+            }
+        }
+    }
+    for (i = 0; i < alarms->ruleCount; i++) {
+        if (alarms->rules[i].kind == ALARM_LOSS) {
+            lost = time - alarms->vital[alarms->rules[i].vital].time >
+                   (uint32_t)alarms->state[i].limit;
+            // only a sample clears, a new gap cancels a pending clear
+            if (lost || !alarms->state[i].active) {
+                updateAlarmRule(alarms, i, lost, false, time);
+            }
+        }
+    }
+}
+
+bool isVitalAlarmed(const ALARMS *alarms, uint8_t vital) {
+    const ALARM_VITAL *v = &alarms->vital[vital];
+    uint32_t mask = v->count == 32 ? 0xFFFFFFFF : (1u << v->count) - 1;
+    return (alarms->active >> v->first) & mask;
+}
+
+// Active rule with the highest priority, -1 if none
+int8_t getTopAlarm(const ALARMS *alarms) {
+    int8_t top = -1;
+    uint8_t i;
+    for (i = 0; i < alarms->ruleCount; i++) {
+        if ((alarms->active & (1u << i)) &&
+            (top < 0 ||
+             alarms->rules[i].priority > alarms->rules[top].priority)) {
+            top = i;
+        }
+    }
+    return top;
+}
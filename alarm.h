@@ -0,0 +1,87 @@
+// Alarm Engine Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef ALARM_H_
+#define ALARM_H_
+
+// Rules fit in a 32-bit active mask
+#define ALARM_MAX_RULES 32
+#define ALARM_MAX_VITALS 4
+// Age a silent vital is held at, past any loss limit and half the clock
+// range so unsigned differences do not wrap
+#define ALARM_MAX_AGE 0x80000000u
+
+typedef enum _ALARM_KIND {
+    ALARM_LOW,   // value below limit, clears above limit + hysteresis
+    ALARM_HIGH,  // value above limit, clears below limit - hysteresis
+    ALARM_RATE,  // |change| per second above limit, clears below
+                 // limit - hysteresis
+    ALARM_LOSS   // no sample for limit clocks, clears on the next sample
+} ALARM_KIND;
+
+// One row of the rule table, rows of a vital must be next to each other
+typedef struct _ALARM_RULE {
+    uint8_t vital;
+    ALARM_KIND kind;
+    uint8_t priority;    // higher is more urgent
+    int32_t limit;       // Q16.16 value or rate, clocks for ALARM_LOSS
+    int32_t hysteresis;  // Q16.16
+    uint32_t debounce;   // clocks a change must hold before it is reported
+} ALARM_RULE;
+
+// rule is the table index, value the newest sample of its vital
+typedef void (*ALARM_CALLBACK)(uint8_t rule, bool active, int32_t value,
+                               uint32_t time);
+
+typedef struct _ALARM_STATE {
+    int32_t limit;
+    uint32_t since;  // time the condition started to differ from active
+    bool changing;
+    bool active;
+} ALARM_STATE;
+
+typedef struct _ALARM_VITAL {
+    int32_t value;  // Q16.16
+    uint32_t time;
+    bool seen;
+    uint8_t first;  // rule index range
+    uint8_t count;
+} ALARM_VITAL;
+
+typedef struct _ALARMS {
+    const ALARM_RULE *rules;
+    uint8_t ruleCount;
+    uint32_t clocksPerSecond;
+    ALARM_CALLBACK callback;
+    ALARM_STATE state[ALARM_MAX_RULES];
+    ALARM_VITAL vital[ALARM_MAX_VITALS];
+    uint32_t active;  // bit per rule
+} ALARMS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initAlarms(ALARMS *alarms, const ALARM_RULE *rules, uint8_t ruleCount,
+                uint32_t clocksPerSecond, ALARM_CALLBACK callback,
+                uint32_t time);
+void setAlarmLimit(ALARMS *alarms, uint8_t rule, int32_t limit);
+void addAlarmSample(ALARMS *alarms, uint8_t vital, int32_t value,
+                    uint32_t time);
+void checkAlarmLoss(ALARMS *alarms, uint32_t time);
+bool isVitalAlarmed(const ALARMS *alarms, uint8_t vital);
+int8_t getTopAlarm(const ALARMS *alarms);
+
+#endif
@@ -0,0 +1,237 @@
+// Benchmark Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Times the signal processing kernels with the DWT cycle counter. Every
+// kernel works on its own state and synthetic input, so the live tasks are
+// not disturbed. Interrupts stay enabled; each kernel is run BENCH_RUNS
+// times and the fastest run is kept, which leaves out the runs an
+// interrupt landed in.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "bench.h"
+#include "bits.h"
+#include "cycles.h"
+#include "dsp.h"
+#include "fft.h"
+#include "heartrate.h"
+#include "lockin.h"
+#include "number.h"
+#include "ppg.h"
+
+#define BENCH_RUNS 8
+
+// Lock-in input, two decimation periods of alternating LED phases
+#define BENCH_LOCKIN_SAMPLES (2 * PPG_LOCKIN_DECIMATION)
+
+// DSP kernels, one block each
+#define BENCH_BLOCK 64
+#define BENCH_STAGES 2
+#define BENCH_TAPS 32
+
+typedef struct _BENCH {
+    const char *name;
+    uint16_t items;
+    void (*setup)(void);
+    void (*run)(void);
+} BENCH;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+uint32_t bench_seed = 1;
+
+uint16_t bench_adc[BENCH_LOCKIN_SAMPLES];
+LOCKIN bench_lockin;
+int32_t bench_amplitude;
+
+q15_t bench_q15[BENCH_BLOCK];
+q15_t bench_q15_out[BENCH_BLOCK];
+q31_t bench_q31[BENCH_BLOCK];
+q31_t bench_q31_out[BENCH_BLOCK];
+q15_t bench_taps[BENCH_TAPS];
+q15_t bench_fir_state[BENCH_TAPS - 1 + BENCH_BLOCK];
+BIQUAD_Q15_STAGE bench_q15_stages[BENCH_STAGES];
+BIQUAD_Q31_STAGE bench_q31_stages[BENCH_STAGES];
+BIQUAD_Q15 bench_biquad_q15;
+BIQUAD_Q31 bench_biquad_q31;
+FIR_Q15 bench_fir;
+DC_BLOCKER_Q15 bench_dc_blocker;
+
+q15_t bench_fft[FFT_LENGTH];
+HEART_RATE bench_heart_rate;
+
+uint8_t bench_lines[24];
+uint8_t bench_columns[3][8];
+
+// Typical shell arguments
+const char *bench_integers[] = {"150", "-12345678", "0x1F", "2147483647"};
+const char *bench_fixeds[] = {"40.5", "-1.25", "20", "30000.125"};
+int32_t bench_value;
+
+// Butterworth low-pass at fs / 20, the same section twice, Q14 and Q30
+const q15_t bench_q15_coeffs[BENCH_STAGES * BIQUAD_COEFFS] = {
+    329, 658, 329, 25576, -10508, 329, 658, 329, 25576, -10508};
+const q31_t bench_q31_coeffs[BENCH_STAGES * BIQUAD_COEFFS] = {
+    21564350, 43128699, 21564350, 1676130396, -688645970,
+    21564350, 43128699, 21564350, 1676130396, -688645970};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Linear congruential generator, repeatable input for every run
+static uint32_t bench_random() {
+    bench_seed = bench_seed * 1664525 + 1013904223;
+    return bench_seed;
+}
+
+static void setup_lockin() {
+    uint16_t i;
+    for (i = 0; i < BENCH_LOCKIN_SAMPLES; i++) {
+        bench_adc[i] = bench_random() >> 20;
+    }
+    initLockin(&bench_lockin, PPG_LOCKIN_SHIFT, PPG_LOCKIN_DECIMATION);
+}
+
+static void run_lockin() {
+    uint16_t i;
+    for (i = 0; i < BENCH_LOCKIN_SAMPLES; i++) {
+        updateLockin(&bench_lockin, bench_adc[i], i & 1, &bench_amplitude);
+    }
+}
+
+static void setup_dsp() {
+    uint16_t i;
+    for (i = 0; i < BENCH_BLOCK; i++) {
+        bench_q15[i] = bench_random() >> 16;
+        bench_q31[i] = (int32_t)bench_random() >> 8;
+    }
+    for (i = 0; i < BENCH_TAPS; i++) {
+        bench_taps[i] = (bench_random() >> 16) / BENCH_TAPS;
+    }
+    initBiquadQ15(&bench_biquad_q15, bench_q15_stages, bench_q15_coeffs,
+                  BENCH_STAGES);
+    initBiquadQ31(&bench_biquad_q31, bench_q31_stages, bench_q31_coeffs,
+                  BENCH_STAGES);
+    initFirQ15(&bench_fir, bench_taps, bench_fir_state, BENCH_TAPS);
+    initDcBlockerQ15(&bench_dc_blocker, 32604);
+}
+
+static void run_biquad_q15() {
+    runBiquadQ15(&bench_biquad_q15, bench_q15, bench_q15_out, BENCH_BLOCK);
+}
+
+static void run_biquad_q31() {
+    runBiquadQ31(&bench_biquad_q31, bench_q31, bench_q31_out, BENCH_BLOCK);
+}
+
+static void run_fir() {
+    runFirQ15(&bench_fir, bench_q15, bench_q15_out, BENCH_BLOCK);
+}
+
+static void run_dc_blocker() {
+    runDcBlockerQ15(&bench_dc_blocker, bench_q15, bench_q15_out,
+                    BENCH_BLOCK);
+}
+
+static void setup_fft() {
+    uint16_t i;
+    for (i = 0; i < FFT_LENGTH; i++) {
+        bench_fft[i] = (int32_t)bench_random() >> 18;
+    }
+}
+
+static void run_fft() { runRfftQ15(bench_fft); }
+
+// A full window, so every added sample makes an estimate
+static void setup_heart_rate() {
+    uint16_t i;
+    initHeartRate(&bench_heart_rate, PPG_AMPLITUDE_HZ);
+    for (i = 0; i < FFT_LENGTH; i++) {
+        addHeartRateSample(&bench_heart_rate, bench_random() >> 22);
+    }
+}
+
+static void run_heart_rate() {
+    bench_heart_rate.sinceUpdate = bench_heart_rate.sampleHz - 1;
+    addHeartRateSample(&bench_heart_rate, bench_random() >> 22);
+}
+
+static void setup_transpose() {
+    uint8_t i;
+    for (i = 0; i < 24; i++) {
+        bench_lines[i] = bench_random() >> 24;
+    }
+}
+
+// The three transposes of one multi-gauge HX711 read
+static void run_transpose() {
+    transposeBits8x8(&bench_lines[0], bench_columns[0]);
+    transposeBits8x8(&bench_lines[8], bench_columns[1]);
+    transposeBits8x8(&bench_lines[16], bench_columns[2]);
+}
+
+static void setup_number() {}
+
+static void run_integer() {
+    uint8_t i;
+    for (i = 0; i < 4; i++) {
+        parseInteger(bench_integers[i], strlen(bench_integers[i]),
+                     &bench_value);
+    }
+}
+
+static void run_fixed() {
+    uint8_t i;
+    for (i = 0; i < 4; i++) {
+        parseFixed(bench_fixeds[i], strlen(bench_fixeds[i]), &bench_value);
+    }
+}
+
+// Biquads are two stages, the FIR has 32 taps, heartrate is one estimate
+const BENCH benches[] = {
+    {"lockin", BENCH_LOCKIN_SAMPLES, setup_lockin, run_lockin},
+    {"biquad q15", BENCH_BLOCK, setup_dsp, run_biquad_q15},
+    {"biquad q31", BENCH_BLOCK, setup_dsp, run_biquad_q31},
+    {"fir q15", BENCH_BLOCK, setup_dsp, run_fir},
+    {"dc block", BENCH_BLOCK, setup_dsp, run_dc_blocker},
+    {"rfft 256", FFT_LENGTH, setup_fft, run_fft},
+    {"heartrate", 1, setup_heart_rate, run_heart_rate},
+    {"transpose", 3, setup_transpose, run_transpose},
+    {"integer", 4, setup_number, run_integer},
+    {"fixed", 4, setup_number, run_fixed},
+};
+#define NUM_BENCHES (sizeof(benches) / sizeof(benches[0]))
+
+void runBenchmarks(BENCH_REPORT report) {
+    uint8_t i, r;
+    for (i = 0; i < NUM_BENCHES; i++) {
+        uint32_t best = UINT32_MAX;
+        benches[i].setup();
+        for (r = 0; r < BENCH_RUNS; r++) {
+            uint32_t start = DWT_CYCCNT;
+            benches[i].run();
+            uint32_t cycles = DWT_CYCCNT - start;
+            if (cycles < best) {
+                best = cycles;
+            }
+        }
+        report(benches[i].name, best, benches[i].items);
+    }
+}
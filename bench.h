@@ -0,0 +1,29 @@
+// Benchmark Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+// Called once per kernel with the fastest run and the items it processed
+typedef void (*BENCH_REPORT)(const char *name, uint32_t cycles,
+                             uint16_t items);
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void runBenchmarks(BENCH_REPORT report);
+
+#endif
@@ -0,0 +1,55 @@
+// Bit Manipulation Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bits.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Transpose an 8 x 8 bit matrix: in holds 8 rows, the MSB is column 0.
+// out[j] collects column j, with row 0 in its MSB. (Hacker's Delight 7-3)
+void transposeBits8x8(const uint8_t *in, uint8_t *out) {
+    uint32_t x, y, t;
+    x = ((uint32_t)in[0] << 24) | ((uint32_t)in[1] << 16) |
+        ((uint32_t)in[2] << 8) | in[3];
+    y = ((uint32_t)in[4] << 24) | ((uint32_t)in[5] << 16) |
+        ((uint32_t)in[6] << 8) | in[7];
+
+    // swap 1 x 1, then 2 x 2, then 4 x 4 blocks across the diagonal
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    out[0] = x >> 24;
+    out[1] = x >> 16;
+    out[2] = x >> 8;
+    out[3] = x;
+    out[4] = y >> 24;
+    out[5] = y >> 16;
+    out[6] = y >> 8;
+    out[7] = y;
+}
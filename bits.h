@@ -0,0 +1,25 @@
+// Bit Manipulation Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef BITS_H_
+#define BITS_H_
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void transposeBits8x8(const uint8_t *in, uint8_t *out);
+
+#endif
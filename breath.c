@@ -0,0 +1,170 @@
+// Breath Detector
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// Strain gauge samples are averaged in groups of config->decimation, which
+// also notches mains pickup at 80 samples per second. Each average is
+// low-pass filtered, a slow baseline is taken away, and the remainder is
+// searched for alternating peaks and troughs. A turn is only accepted once
+// the signal has moved back by a quarter of the recent breath swing (or
+// minSwing, whichever is larger), so noise riding on a slope can not flip
+// the direction.
+//
+// Breaths are timed trough to trough from the sample timestamps, not by
+// counting samples. The trough time is refined with a parabola through the
+// lowest filtered sample and its neighbours, so the interval resolution is
+// finer than the decimated sample spacing.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "breath.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initBreath(BREATH *breath, const BREATH_CONFIG *config) {
+    breath->config = config;
+    initBiquadQ31(&breath->filter, &breath->stage, config->lowPass, 1);
+    breath->sum = 0;
+    breath->firstTime = 0;
+    breath->count = 0;
+    breath->baselineSum = 0;
+    breath->last = 0;
+    breath->lastTime = 0;
+    breath->extreme = 0;
+    breath->extremeAt = 0;
+    breath->before = breath->after = 0;
+    breath->beforeAt = breath->afterAt = 0;
+    breath->needAfter = false;
+    breath->peak = 0;
+    breath->trough = 0;
+    breath->amplitude = 0;
+    breath->troughAt = 0;
+    breath->interval = 0;
+    breath->started = false;
+    breath->rising = true;
+    breath->timing = false;
+}
+
+// Hysteresis needed before a turn is accepted
+int32_t getBreathThreshold(const BREATH *breath) {
+    int32_t threshold = breath->amplitude >> 2;
+    if (threshold < breath->config->minSwing) {
+        threshold = breath->config->minSwing;
+    }
+    return threshold;
+}
+
+void setBreathExtreme(BREATH *breath, int32_t signal, uint32_t time) {
+    breath->extreme = signal;
+    breath->extremeAt = time;
+    breath->before = breath->last;
+    breath->beforeAt = breath->lastTime;
+    breath->needAfter = true;
+}
+
+// Vertex of the parabola through the extreme and its neighbours
+uint32_t getBreathTroughTime(const BREATH *breath) {
+    int32_t curve = breath->before - 2 * breath->extreme + breath->after;
+    int32_t span = breath->afterAt - breath->beforeAt;
+    int64_t offset;
+    if (curve <= 0) {
+        return breath->extremeAt;
+    }
+    offset = (int64_t)(breath->before - breath->after) * span / (4 * curve);
+    return breath->extremeAt + (int32_t)offset;
+}
+
+// Feed one sample with its timestamp, returns whether it completed a
+// filtered sample and which turn that sample completed, if any
+BREATH_EVENT updateBreath(BREATH *breath, int32_t sample, uint32_t time) {
+    const BREATH_CONFIG *config = breath->config;
+    BREATH_EVENT event = BREATH_SAMPLE;
+    q31_t filtered;
+    int32_t signal, baseline;
+    uint32_t troughAt, interval;
+
+    // decimate, stamping the average with the middle of its samples
+    if (breath->count == 0) {
+        breath->firstTime = time;
+    }
+    breath->sum += sample;
+    breath->count++;
+    if (breath->count < config->decimation) {
+        return BREATH_NONE;
+    }
+    sample = breath->sum / config->decimation;
+    time = breath->firstTime + (time - breath->firstTime) / 2;
+    breath->sum = 0;
+    breath->count = 0;
+
+    if (!breath->started) {
+        // start the filter and baseline settled on the first reading
+        breath->stage.x1 = breath->stage.x2 = sample;
+        breath->stage.y1 = breath->stage.y2 = sample;
+        breath->baselineSum = sample * (1 << config->baselineShift);
+        breath->started = true;
+    }
+    runBiquadQ31(&breath->filter, &sample, &filtered, 1);
+    baseline = breath->baselineSum >> config->baselineShift;
+    breath->baselineSum += filtered - baseline;
+    signal = filtered - baseline;
+
+    if (breath->rising) {
+        if (signal > breath->extreme) {
+            setBreathExtreme(breath, signal, time);
+        } else if (breath->extreme - signal > getBreathThreshold(breath)) {
+            breath->peak = breath->extreme;
+            setBreathExtreme(breath, signal, time);
+            breath->rising = false;
+            event = BREATH_PEAK;
+        }
+    } else {
+        if (signal < breath->extreme) {
+            setBreathExtreme(breath, signal, time);
+        } else {
+            if (breath->needAfter) {
+                breath->after = signal;
+                breath->afterAt = time;
+                breath->needAfter = false;
+            }
+            if (signal - breath->extreme > getBreathThreshold(breath)) {
+                breath->trough = breath->extreme;
+                troughAt = getBreathTroughTime(breath);
+                interval = troughAt - breath->troughAt;
+                event = BREATH_TROUGH;
+                if (!breath->timing || interval > config->maxPeriod) {
+                    breath->troughAt = troughAt;
+                    breath->timing = true;
+                } else if (interval >= config->minPeriod) {
+                    breath->amplitude +=
+                        (breath->peak - breath->trough - breath->amplitude) >>
+                        2;
+                    breath->interval = interval;
+                    breath->troughAt = troughAt;
+                    event = BREATH_CYCLE;
+                }
+                // a trough too soon after the last one is kept out of the
+                // timing
+                setBreathExtreme(breath, signal, time);
+                breath->rising = true;
+            }
+        }
+    }
+    breath->last = signal;
+    breath->lastTime = time;
+    return event;
+}
@@ -0,0 +1,73 @@
+// Breath Detector
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef BREATH_H_
+#define BREATH_H_
+
+#include "dsp.h"
+
+typedef enum _BREATH_EVENT {
+    BREATH_NONE,    // sample taken into the decimator
+    BREATH_SAMPLE,  // new filtered sample in last, no turn
+    BREATH_PEAK,    // end of an inhale
+    BREATH_TROUGH,  // end of an exhale that did not complete a valid breath
+    BREATH_CYCLE    // end of an exhale, interval holds the breath period
+} BREATH_EVENT;
+
+// Levels are in HX711 counts, timing is in timestamp ticks
+typedef struct _BREATH_CONFIG {
+    const q31_t *lowPass;  // one Q30 biquad stage at the decimated rate
+    uint8_t decimation;     // input samples averaged per filtered sample
+    uint8_t baselineShift;  // baseline time constant is 2^shift samples
+    int32_t minSwing;       // smallest peak to trough change counted
+    uint32_t minPeriod;     // troughs closer than this are noise
+    uint32_t maxPeriod;     // longer gaps restart the interval timing
+} BREATH_CONFIG;
+
+typedef struct _BREATH {
+    const BREATH_CONFIG *config;
+    BIQUAD_Q31 filter;
+    BIQUAD_Q31_STAGE stage;
+    int32_t sum;          // decimator
+    uint32_t firstTime;
+    uint8_t count;
+    int32_t baselineSum;  // baseline << baselineShift
+    int32_t last;         // latest baseline-free signal and its time
+    uint32_t lastTime;
+    int32_t extreme;      // running max or min since the last turn
+    uint32_t extremeAt;
+    int32_t before;       // neighbours of the extreme, for interpolation
+    uint32_t beforeAt;
+    int32_t after;
+    uint32_t afterAt;
+    bool needAfter;
+    int32_t peak;
+    int32_t trough;
+    int32_t amplitude;    // smoothed peak to trough swing
+    uint32_t troughAt;
+    uint32_t interval;    // last breath period
+    bool started;
+    bool rising;
+    bool timing;          // troughAt holds a usable trough
+} BREATH;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initBreath(BREATH *breath, const BREATH_CONFIG *config);
+BREATH_EVENT updateBreath(BREATH *breath, int32_t sample, uint32_t time);
+
+#endif
@@ -0,0 +1,197 @@
+// Pulse Capture Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// SIGNAL_IN on PC6 (WT1CCP0)
+// uDMA channel 12 (encoding 3) moves WTIMER1 capture values to RAM
+// DWT cycle counter, started by initHw() before initCapture()
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "capture.h"
+#include "cycles.h"
+#include "ring.h"
+#include "tm4c123gh6pm.h"
+
+#define CAPTURE_DMA_CH 12
+#define CAPTURE_DMA_ENC 3
+#define CAPTURE_DMA_MASK (1 << CAPTURE_DMA_CH)
+#define DMA_ALT_OFFSET 32
+
+// 32-bit words from the fixed capture register into incrementing RAM
+#define CAPTURE_DMA_CTL                                                \
+    (UDMA_CHCTL_DSTINC_32 | UDMA_CHCTL_DSTSIZE_32 |                    \
+     UDMA_CHCTL_SRCINC_NONE | UDMA_CHCTL_SRCSIZE_32 |                  \
+     UDMA_CHCTL_ARBSIZE_1 |                                            \
+     ((CAPTURE_BLOCK_SIZE - 1) << UDMA_CHCTL_XFERSIZE_S) |             \
+     UDMA_CHCTL_XFERMODE_PINGPONG)
+
+// Beats waiting for the main loop
+SPSC_RING(BEAT_RING, BeatRing, CAPTURE_BEAT, CAPTURE_BEATS)
+
+typedef struct _DMA_CONTROL {
+    volatile uint32_t *srcEnd;
+    volatile uint32_t *dstEnd;
+    volatile uint32_t control;
+    uint32_t unused;
+} DMA_CONTROL;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// Primary control structures (0-31) followed by alternates (32-63)
+#pragma DATA_ALIGN(dmaTable, 1024)
+DMA_CONTROL dmaTable[64];
+
+// Circular buffer: primary fills the first block, alternate the second
+volatile uint32_t captureBuffer[2 * CAPTURE_BLOCK_SIZE];
+
+uint8_t nextBlock = 0;
+uint8_t blockTaken = 0;  // entries of nextBlock already flushed
+uint32_t lastTimestamp = 0;
+bool firstTimestamp = true;
+uint32_t captureClockOffset = 0;  // DWT_CYCCNT - WTIMER1 count
+BEAT_RING captureBeats;
+volatile uint32_t captureCount = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void loadCaptureBlock(uint8_t entry, uint8_t block) {
+    dmaTable[entry].srcEnd = &WTIMER1_TAR_R;
+    dmaTable[entry].dstEnd =
+        &captureBuffer[block * CAPTURE_BLOCK_SIZE + CAPTURE_BLOCK_SIZE - 1];
+    dmaTable[entry].control = CAPTURE_DMA_CTL;
+}
+
+// Turn edge timestamps first to end - 1 of a block into beats
+void processCaptureEntries(uint8_t block, uint8_t first, uint8_t end) {
+    volatile uint32_t *ts = &captureBuffer[block * CAPTURE_BLOCK_SIZE];
+    CAPTURE_BEAT beat;
+    uint8_t i;
+    for (i = first; i < end; i++) {
+        if (!firstTimestamp) {
+            // free-running up counter, so unsigned subtraction handles wrap
+            beat.period = ts[i] - lastTimestamp;
+            beat.time = ts[i] + captureClockOffset;
+            pushBeatRing(&captureBeats, beat);
+            captureCount++;
+        }
+        firstTimestamp = false;
+        lastTimestamp = ts[i];
+    }
+}
+
+// WTIMER1 is shared: A captures pulse edges here, B is the PPG LED PWM
+// (ppg.c). CFG may only change while both halves are off, so the split and
+// both modes are set once here before either half is started.
+void initWideTimer1() {
+    WTIMER1_CTL_R &= ~(TIMER_CTL_TAEN | TIMER_CTL_TBEN);
+    WTIMER1_CFG_R = 4;  // configure as 32-bit split counters
+    // A: edge time mode, count up
+    WTIMER1_TAMR_R = TIMER_TAMR_TACMR | TIMER_TAMR_TAMR_CAP | TIMER_TAMR_TACDIR;
+    // B: PWM, periodic count down
+    WTIMER1_TBMR_R = TIMER_TBMR_TBAMS | TIMER_TBMR_TBMR_PERIOD;
+}
+
+// Configure WTIMER1A for free-running edge time capture with uDMA requests,
+// call before initPpg()
+void initCapture() {
+    uint32_t state;
+    initBeatRing(&captureBeats);
+
+    // Enable clocks
+    SYSCTL_RCGCDMA_R |= SYSCTL_RCGCDMA_R0;
+    SYSCTL_RCGCWTIMER_R |= SYSCTL_RCGCWTIMER_R1;
+    _delay_cycles(3);
+
+    // Configure uDMA
+    UDMA_CFG_R = UDMA_CFG_MASTEN;             // enable controller
+    UDMA_CTLBASE_R = (uint32_t)dmaTable;      // set control table base
+    UDMA_CHMAP1_R &= ~UDMA_CHMAP1_CH12SEL_M;  // map channel 12 to WTIMER1A
+    UDMA_CHMAP1_R |= CAPTURE_DMA_ENC << UDMA_CHMAP1_CH12SEL_S;
+    UDMA_PRIOCLR_R = CAPTURE_DMA_MASK;        // default priority
+    UDMA_ALTCLR_R = CAPTURE_DMA_MASK;         // start with primary
+    UDMA_USEBURSTCLR_R = CAPTURE_DMA_MASK;    // respond to single requests
+    UDMA_REQMASKCLR_R = CAPTURE_DMA_MASK;     // allow peripheral requests
+    loadCaptureBlock(CAPTURE_DMA_CH, 0);
+    loadCaptureBlock(CAPTURE_DMA_CH + DMA_ALT_OFFSET, 1);
+    UDMA_ENASET_R = CAPTURE_DMA_MASK;         // enable channel
+
+    // Configure timer
+    initWideTimer1();
+    WTIMER1_CTL_R &= ~TIMER_CTL_TAEVENT_M;  // capture on positive edge
+    WTIMER1_CTL_R |= TIMER_CTL_TAEVENT_POS;
+    WTIMER1_IMR_R &= ~TIMER_IMR_CAEIM;  // edges only raise uDMA requests
+    // timer B is left alone, it drives the PPG LED
+    WTIMER1_TAV_R = 0;
+    // both count the system clock and wrap at 2^32, so the offset taken
+    // at the start holds for good
+    state = _disable_IRQ();
+    captureClockOffset = DWT_CYCCNT;
+    WTIMER1_CTL_R |= TIMER_CTL_TAEN;  // turn-on counter
+    _restore_interrupts(state);
+    NVIC_EN3_R |=
+        1 << (INT_WTIMER1A - 16 - 96);  // turn-on interrupt 112 (WTIMER1A)
+}
+
+// uDMA block completion, signalled on the WTIMER1A vector
+void wideTimer1Isr() {
+    UDMA_CHIS_R = CAPTURE_DMA_MASK;     // clear channel completion
+    WTIMER1_ICR_R = TIMER_ICR_CAECINT;  // clear raw capture status
+    // a finished structure reads back in stop mode; re-arm it while the
+    // other one keeps filling, taking blocks in the order they completed
+    while ((dmaTable[CAPTURE_DMA_CH + nextBlock * DMA_ALT_OFFSET].control &
+            UDMA_CHCTL_XFERMODE_M) == UDMA_CHCTL_XFERMODE_STOP) {
+        processCaptureEntries(nextBlock, blockTaken, CAPTURE_BLOCK_SIZE);
+        blockTaken = 0;
+        loadCaptureBlock(CAPTURE_DMA_CH + nextBlock * DMA_ALT_OFFSET,
+                         nextBlock);
+        nextBlock ^= 1;
+    }
+}
+
+// Take the timestamps already written to the block being filled, so slow
+// pulses are not held back until CAPTURE_BLOCK_SIZE edges have arrived.
+// Call from the main loop; the block interrupt is held off meanwhile.
+void flushCapture() {
+    uint32_t state = _disable_IRQ();
+    uint32_t control =
+        dmaTable[CAPTURE_DMA_CH + nextBlock * DMA_ALT_OFFSET].control;
+    uint8_t written;
+    // a stopped structure is complete and left to wideTimer1Isr
+    if ((control & UDMA_CHCTL_XFERMODE_M) != UDMA_CHCTL_XFERMODE_STOP) {
+        // the controller keeps the outstanding count minus 1 up to date
+        written = CAPTURE_BLOCK_SIZE - 1 -
+                  ((control & UDMA_CHCTL_XFERSIZE_M) >> UDMA_CHCTL_XFERSIZE_S);
+        processCaptureEntries(nextBlock, blockTaken, written);
+        blockTaken = written;
+    }
+    _restore_interrupts(state);
+}
+
+// Oldest beat not yet taken, false if there is none
+bool getCaptureBeat(CAPTURE_BEAT *beat) {
+    return popBeatRing(&captureBeats, beat);
+}
+
+// Number of periods measured since boot
+uint32_t getCaptureCount() { return captureCount; }
+
+// Beats dropped because the main loop fell behind
+uint32_t getCaptureOverflows() { return captureBeats.overflows; }
@@ -0,0 +1,47 @@
+// Pulse Capture Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// SIGNAL_IN on PC6 (WT1CCP0)
+// uDMA channel 12 (encoding 3) moves WTIMER1 capture values to RAM
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef CAPTURE_H_
+#define CAPTURE_H_
+
+// Timestamps per uDMA block (one CPU interrupt per block)
+#define CAPTURE_BLOCK_SIZE 4
+// Beats queued for the main loop, a power of 2
+#define CAPTURE_BEATS 16
+
+// Edge-to-edge period and the time of the edge ending it, in system clocks.
+// The time is on the DWT cycle counter, the clock of the rest of the main
+// loop.
+typedef struct _CAPTURE_BEAT {
+    uint32_t period;
+    uint32_t time;
+} CAPTURE_BEAT;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initCapture();
+void wideTimer1Isr();
+void flushCapture();
+bool getCaptureBeat(CAPTURE_BEAT *beat);
+uint32_t getCaptureCount();
+uint32_t getCaptureOverflows();
+
+#endif
@@ -0,0 +1,113 @@
+// Configuration Store Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, stores through eeprom.c)
+// System Clock:    -
+
+// Settings are read once at boot and written only when they differ from
+// the newest record. Records alternate between two slots with a rising
+// sequence number and end in a CRC-32, so a reset during a write leaves
+// the previous record to restore. The EEPROM is only reached through
+// readEeprom() and writeEeprom(), which host tools can replace with a RAM
+// array.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "config.h"
+#include "eeprom.h"
+
+// Record: header, sequence, CONFIG, CRC-32 of the words before it
+#define CONFIG_MAGIC 0x43460000  // "CF"
+#define CONFIG_HEADER (CONFIG_MAGIC | CONFIG_VERSION)
+#define CONFIG_DATA_WORDS (sizeof(CONFIG) / 4)
+#define CONFIG_RECORD_WORDS (CONFIG_DATA_WORDS + 3)
+
+typedef struct _CONFIG_RECORD {
+    uint32_t header;
+    uint32_t sequence;
+    CONFIG config;
+    uint32_t crc;
+} CONFIG_RECORD;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint32_t getConfigCrc(const uint32_t *words, uint8_t count) {
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t i, bit;
+    for (i = 0; i < count; i++) {
+        crc ^= words[i];
+        for (bit = 0; bit < 32; bit++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+bool readConfigRecord(uint8_t slot, CONFIG_RECORD *record) {
+    readEeprom(slot * CONFIG_SLOT_WORDS, (uint32_t *)record,
+               CONFIG_RECORD_WORDS);
+    return record->header == CONFIG_HEADER &&
+           record->crc ==
+               getConfigCrc((uint32_t *)record, CONFIG_RECORD_WORDS - 1);
+}
+
+// Fills config from the newest good record, or from defaults if there is
+// none. Returns true if a record was restored.
+bool loadConfig(CONFIG_STORE *store, CONFIG *config, const CONFIG *defaults) {
+    CONFIG_RECORD record;
+    uint8_t slot;
+    bool found = false;
+    store->sequence = 0;
+    store->slot = CONFIG_SLOTS - 1;
+    for (slot = 0; slot < CONFIG_SLOTS; slot++) {
+        if (readConfigRecord(slot, &record) &&
+            (!found || (int32_t)(record.sequence - store->sequence) > 0)) {
+            found = true;
+            store->stored = record.config;
+            store->sequence = record.sequence;
+            store->slot = slot;
+        }
+    }
+    if (!found) {
+        store->stored = *defaults;
+    }
+    *config = store->stored;
+    return found;
+}
+
+// Writes a new record to the older slot if config changed. Returns true if
+// a record was written.
+bool saveConfig(CONFIG_STORE *store, const CONFIG *config) {
+    CONFIG_RECORD record;
+    uint8_t slot = (store->slot + 1) % CONFIG_SLOTS;
+    if (memcmp(config, &store->stored, sizeof(CONFIG)) == 0) {
+        return false;
+    }
+    record.header = CONFIG_HEADER;
+    record.sequence = store->sequence + 1;
+    record.config = *config;
+    record.crc = getConfigCrc((uint32_t *)&record, CONFIG_RECORD_WORDS - 1);
+    // remember the new values even if the write fails, so a bad EEPROM is
+    // not retried on every pass
+    store->stored = *config;
+    if (!writeEeprom(slot * CONFIG_SLOT_WORDS, (uint32_t *)&record,
+                     CONFIG_RECORD_WORDS)) {
+        return false;
+    }
+    store->sequence = record.sequence;
+    store->slot = slot;
+    return true;
+}
@@ -0,0 +1,50 @@
+// Configuration Store Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, stores through eeprom.c)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#include "strain.h"
+
+// Bump when CONFIG changes, records of another version are not restored
+#define CONFIG_VERSION 1
+
+// Two record slots, one EEPROM block each
+#define CONFIG_SLOT_WORDS 16
+#define CONFIG_SLOTS 2
+
+// Settings kept across resets, only whole words so records compare exactly
+typedef struct _CONFIG {
+    int32_t bpmLower;     // Q16.16
+    int32_t bpmUpper;     // Q16.16
+    int32_t breathLower;  // Q16.16
+    int32_t breathUpper;  // Q16.16
+    STRAIN_CAL strain;
+} CONFIG;
+
+typedef struct _CONFIG_STORE {
+    CONFIG stored;      // what the newest record holds
+    uint32_t sequence;  // of the newest record, 0 if there is none
+    uint8_t slot;       // holding the newest record
+} CONFIG_STORE;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+bool loadConfig(CONFIG_STORE *store, CONFIG *config, const CONFIG *defaults);
+bool saveConfig(CONFIG_STORE *store, const CONFIG *config);
+
+#endif
@@ -0,0 +1,36 @@
+// Cycle Counter Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// The Cortex-M4 DWT cycle counter is the one time base of the firmware:
+// trace records, HX711 samples, pulse edges, alarms and the RPC idle
+// timeout all read DWT_CYCCNT. initHw() starts it once; nothing else
+// enables or writes it, so times taken by any module stay comparable.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef CYCLES_H_
+#define CYCLES_H_
+
+#define DEMCR (*((volatile uint32_t *)0xE000EDFC))
+#define DWT_CTRL (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT (*((volatile uint32_t *)0xE0001004))
+#define DEMCR_TRCENA 0x01000000
+#define DWT_CTRL_CYCCNTENA 0x00000001
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initCycleCounter();
+
+#endif
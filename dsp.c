@@ -0,0 +1,255 @@
+// Fixed-Point DSP Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (portable C, Cortex-M4 DSP instructions when available)
+// System Clock:    -
+
+// Kernels are written once against three primitives: a dual 16x16 multiply
+// accumulate into 64 bits (straight and exchanged) and a 16-bit saturate.
+// DSP_SIMD maps them to SMLALD, SMLALDX and SSAT; otherwise they are done
+// in plain C with the same integer arithmetic, so both are bit-exact.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "dsp.h"
+
+#if DSP_SIMD
+#if defined(__TI_TMS470_V7M4__)
+#define DSP_SMLALD(acc, a, b) _smlald((acc), (a), (b))
+#define DSP_SMLALDX(acc, a, b) _smlaldx((acc), (a), (b))
+#define DSP_SAT16(x) _ssata((x), 0, 16)
+#else
+#include <arm_acle.h>
+#define DSP_SMLALD(acc, a, b) __smlald((a), (b), (acc))
+#define DSP_SMLALDX(acc, a, b) __smlaldx((a), (b), (acc))
+#define DSP_SAT16(x) __ssat((x), 16)
+#endif
+#else
+#define DSP_SMLALD(acc, a, b) smlald((acc), (a), (b))
+#define DSP_SMLALDX(acc, a, b) smlaldx((acc), (a), (b))
+#define DSP_SAT16(x) sat16(x)
+#endif
+
+#define LO(w) ((int32_t)(int16_t)(w))
+#define HI(w) ((int32_t)(int16_t)((w) >> 16))
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+#if !DSP_SIMD
+static inline int64_t smlald(int64_t acc, uint32_t a, uint32_t b) {
+    return acc + LO(a) * LO(b) + HI(a) * HI(b);
+}
+
+static inline int64_t smlaldx(int64_t acc, uint32_t a, uint32_t b) {
+    return acc + LO(a) * HI(b) + HI(a) * LO(b);
+}
+
+static inline int32_t sat16(int32_t x) {
+    if (x > INT16_MAX) {
+        return INT16_MAX;
+    }
+    if (x < INT16_MIN) {
+        return INT16_MIN;
+    }
+    return x;
+}
+#endif
+
+static inline uint32_t pack16(q15_t lo, q15_t hi) {
+    return (uint16_t)lo | ((uint32_t)(uint16_t)hi << 16);
+}
+
+// Two adjacent samples as one word, the first in the low half
+static inline uint32_t readQ15x2(const q15_t *p) {
+    uint32_t word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+static inline q31_t sat32(int64_t x) {
+    if (x > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (x < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return (q31_t)x;
+}
+
+void initBiquadQ15(BIQUAD_Q15 *biquad, BIQUAD_Q15_STAGE *stages,
+                   const q15_t *coeffs, uint8_t numStages) {
+    uint8_t i;
+    for (i = 0; i < numStages; i++) {
+        stages[i].b0 = coeffs[0];
+        stages[i].b12 = pack16(coeffs[1], coeffs[2]);
+        stages[i].a12 = pack16(coeffs[3], coeffs[4]);
+        stages[i].x12 = 0;
+        stages[i].y12 = 0;
+        coeffs += BIQUAD_COEFFS;
+    }
+    biquad->stages = stages;
+    biquad->numStages = numStages;
+}
+
+// Direct form I cascade, Q14 coefficients, Q15 data, 64-bit accumulator
+void runBiquadQ15(BIQUAD_Q15 *biquad, const q15_t *in, q15_t *out,
+                  uint16_t blockSize) {
+    uint8_t s;
+    uint16_t n;
+    for (s = 0; s < biquad->numStages; s++) {
+        BIQUAD_Q15_STAGE *stage = &biquad->stages[s];
+        uint32_t x12 = stage->x12;
+        uint32_t y12 = stage->y12;
+        for (n = 0; n < blockSize; n++) {
+            q15_t x = in[n];
+            int64_t acc = (int32_t)stage->b0 * x;
+            acc = DSP_SMLALD(acc, stage->b12, x12);
+            acc = DSP_SMLALD(acc, stage->a12, y12);
+            q15_t y = DSP_SAT16((int32_t)((acc + (1 << 13)) >> 14));
+            x12 = (x12 << 16) | (uint16_t)x;
+            y12 = (y12 << 16) | (uint16_t)y;
+            out[n] = y;
+        }
+        stage->x12 = x12;
+        stage->y12 = y12;
+        // later stages filter in place
+        in = out;
+    }
+}
+
+void initBiquadQ31(BIQUAD_Q31 *biquad, BIQUAD_Q31_STAGE *stages,
+                   const q31_t *coeffs, uint8_t numStages) {
+    uint8_t i;
+    for (i = 0; i < numStages; i++) {
+        stages[i].b0 = coeffs[0];
+        stages[i].b1 = coeffs[1];
+        stages[i].b2 = coeffs[2];
+        stages[i].a1 = coeffs[3];
+        stages[i].a2 = coeffs[4];
+        stages[i].x1 = stages[i].x2 = 0;
+        stages[i].y1 = stages[i].y2 = 0;
+        coeffs += BIQUAD_COEFFS;
+    }
+    biquad->stages = stages;
+    biquad->numStages = numStages;
+}
+
+// Direct form I cascade, Q30 coefficients, Q31 data, 64-bit accumulator.
+// The accumulator has no guard bits, so input should leave one bit of
+// headroom (24-bit HX711 counts are fine).
+void runBiquadQ31(BIQUAD_Q31 *biquad, const q31_t *in, q31_t *out,
+                  uint16_t blockSize) {
+    uint8_t s;
+    uint16_t n;
+    for (s = 0; s < biquad->numStages; s++) {
+        BIQUAD_Q31_STAGE *st = &biquad->stages[s];
+        for (n = 0; n < blockSize; n++) {
+            q31_t x = in[n];
+            int64_t acc = (int64_t)st->b0 * x + (int64_t)st->b1 * st->x1 +
+                          (int64_t)st->b2 * st->x2 + (int64_t)st->a1 * st->y1 +
+                          (int64_t)st->a2 * st->y2;
+            q31_t y = sat32((acc + (1 << 29)) >> 30);
+            st->x2 = st->x1;
+            st->x1 = x;
+            st->y2 = st->y1;
+            st->y1 = y;
+            out[n] = y;
+        }
+        in = out;
+    }
+}
+
+void initFirQ15(FIR_Q15 *fir, const q15_t *coeffs, q15_t *state,
+                uint16_t numTaps) {
+    fir->coeffs = coeffs;
+    fir->state = state;
+    fir->numTaps = numTaps;
+    memset(state, 0, (numTaps - 1) * sizeof(q15_t));
+}
+
+// y[n] = sum b[k] x[n-k], two taps per MAC
+void runFirQ15(FIR_Q15 *fir, const q15_t *in, q15_t *out, uint16_t blockSize) {
+    uint16_t numTaps = fir->numTaps;
+    const q15_t *b = fir->coeffs;
+    q15_t *state = fir->state;
+    uint16_t n, j;
+
+    // history (oldest first) followed by the new block
+    memcpy(&state[numTaps - 1], in, blockSize * sizeof(q15_t));
+
+    for (n = 0; n < blockSize; n++) {
+        const q15_t *x = &state[n];
+        int64_t acc = 0;
+        // x[j] pairs with b[numTaps - 1 - j]; the coefficient word at
+        // b[numTaps - 2 - j] holds them in the opposite order, hence the
+        // exchanged MAC
+        for (j = 0; j + 1 < numTaps; j += 2) {
+            acc = DSP_SMLALDX(acc, readQ15x2(&x[j]),
+                              readQ15x2(&b[numTaps - 2 - j]));
+        }
+        if (j < numTaps) {
+            acc += (int32_t)x[j] * b[0];
+        }
+        out[n] = DSP_SAT16((int32_t)((acc + (1 << 14)) >> 15));
+    }
+
+    memmove(state, &state[blockSize], (numTaps - 1) * sizeof(q15_t));
+}
+
+void initMovingAverageQ15(MOVING_AVERAGE_Q15 *average, q15_t *buffer,
+                          uint8_t log2Length) {
+    average->buffer = buffer;
+    average->sum = 0;
+    average->index = 0;
+    average->log2Length = log2Length;
+    memset(buffer, 0, (1 << log2Length) * sizeof(q15_t));
+}
+
+// Running sum, constant cost per sample regardless of window length
+void runMovingAverageQ15(MOVING_AVERAGE_Q15 *average, const q15_t *in,
+                         q15_t *out, uint16_t blockSize) {
+    uint16_t mask = (1 << average->log2Length) - 1;
+    uint16_t n;
+    for (n = 0; n < blockSize; n++) {
+        average->sum += in[n] - average->buffer[average->index];
+        average->buffer[average->index] = in[n];
+        average->index = (average->index + 1) & mask;
+        out[n] = average->sum >> average->log2Length;
+    }
+}
+
+void initDcBlockerQ15(DC_BLOCKER_Q15 *blocker, q15_t pole) {
+    blocker->pole = pole;
+    blocker->x1 = 0;
+    blocker->y1 = 0;
+}
+
+// y[n] = x[n] - x[n-1] + pole * y[n-1]
+void runDcBlockerQ15(DC_BLOCKER_Q15 *blocker, const q15_t *in, q15_t *out,
+                     uint16_t blockSize) {
+    q15_t x1 = blocker->x1;
+    q15_t y1 = blocker->y1;
+    uint16_t n;
+    for (n = 0; n < blockSize; n++) {
+        int64_t acc = ((int64_t)(in[n] - x1) << 15) +
+                      (int32_t)blocker->pole * y1;
+        x1 = in[n];
+        y1 = DSP_SAT16((int32_t)((acc + (1 << 14)) >> 15));
+        out[n] = y1;
+    }
+    blocker->x1 = x1;
+    blocker->y1 = y1;
+}
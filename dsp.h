@@ -0,0 +1,106 @@
+// Fixed-Point DSP Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (portable C, Cortex-M4 DSP instructions when available)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef DSP_H_
+#define DSP_H_
+
+// DSP_SIMD selects the dual 16-bit MAC (SMLALD) and SSAT paths. It defaults
+// on for Cortex-M4 builds and can be forced off with -DDSP_SIMD=0 to run the
+// portable reference code; both give bit-identical results.
+#ifndef DSP_SIMD
+#if defined(__TI_TMS470_V7M4__) || defined(__ARM_FEATURE_DSP)
+#define DSP_SIMD 1
+#else
+#define DSP_SIMD 0
+#endif
+#endif
+
+typedef int16_t q15_t;
+typedef int32_t q31_t;
+
+// Biquad coefficients are given per stage as {b0, b1, b2, a1, a2} with the
+// feedback terms already negated: y = b0x + b1x1 + b2x2 + a1y1 + a2y2.
+// Q15 stages take Q14 coefficients, Q31 stages take Q30 coefficients, so
+// values up to +/-2 fit.
+#define BIQUAD_COEFFS 5
+
+typedef struct _BIQUAD_Q15_STAGE {
+    q15_t b0;
+    uint32_t b12;  // b1 low half, b2 high half
+    uint32_t a12;  // a1 low half, a2 high half
+    uint32_t x12;  // x[n-1] low half, x[n-2] high half
+    uint32_t y12;  // y[n-1] low half, y[n-2] high half
+} BIQUAD_Q15_STAGE;
+
+typedef struct _BIQUAD_Q15 {
+    BIQUAD_Q15_STAGE *stages;
+    uint8_t numStages;
+} BIQUAD_Q15;
+
+typedef struct _BIQUAD_Q31_STAGE {
+    q31_t b0, b1, b2, a1, a2;
+    q31_t x1, x2, y1, y2;
+} BIQUAD_Q31_STAGE;
+
+typedef struct _BIQUAD_Q31 {
+    BIQUAD_Q31_STAGE *stages;
+    uint8_t numStages;
+} BIQUAD_Q31;
+
+// State must hold numTaps - 1 + blockSize samples for the largest block
+typedef struct _FIR_Q15 {
+    const q15_t *coeffs;  // Q15, b[0] first
+    q15_t *state;
+    uint16_t numTaps;
+} FIR_Q15;
+
+// Window length is 2^log2Length samples
+typedef struct _MOVING_AVERAGE_Q15 {
+    q15_t *buffer;
+    int32_t sum;
+    uint16_t index;
+    uint8_t log2Length;
+} MOVING_AVERAGE_Q15;
+
+typedef struct _DC_BLOCKER_Q15 {
+    q15_t pole;  // Q15, e.g. 0.995 for a cutoff near fs / 1000
+    q15_t x1;
+    q15_t y1;
+} DC_BLOCKER_Q15;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initBiquadQ15(BIQUAD_Q15 *biquad, BIQUAD_Q15_STAGE *stages,
+                   const q15_t *coeffs, uint8_t numStages);
+void runBiquadQ15(BIQUAD_Q15 *biquad, const q15_t *in, q15_t *out,
+                  uint16_t blockSize);
+void initBiquadQ31(BIQUAD_Q31 *biquad, BIQUAD_Q31_STAGE *stages,
+                   const q31_t *coeffs, uint8_t numStages);
+void runBiquadQ31(BIQUAD_Q31 *biquad, const q31_t *in, q31_t *out,
+                  uint16_t blockSize);
+void initFirQ15(FIR_Q15 *fir, const q15_t *coeffs, q15_t *state,
+                uint16_t numTaps);
+void runFirQ15(FIR_Q15 *fir, const q15_t *in, q15_t *out, uint16_t blockSize);
+void initMovingAverageQ15(MOVING_AVERAGE_Q15 *average, q15_t *buffer,
+                          uint8_t log2Length);
+void runMovingAverageQ15(MOVING_AVERAGE_Q15 *average, const q15_t *in,
+                         q15_t *out, uint16_t blockSize);
+void initDcBlockerQ15(DC_BLOCKER_Q15 *blocker, q15_t pole);
+void runDcBlockerQ15(DC_BLOCKER_Q15 *blocker, const q15_t *in, q15_t *out,
+                     uint16_t blockSize);
+
+#endif
@@ -0,0 +1,89 @@
+// EEPROM Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// 2 KB on-chip EEPROM, 32 blocks of 16 words
+
+// Reads take a few cycles per word. A word write takes tens of
+// microseconds to milliseconds, so writes are meant for the main loop and
+// words that already hold the value are skipped to save wear.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "eeprom.h"
+#include "tm4c123gh6pm.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void waitEeprom() {
+    while (EEPROM_EEDONE_R & EEPROM_EEDONE_WORKING);
+}
+
+void seekEeprom(uint16_t address) {
+    EEPROM_EEBLOCK_R = address / EEPROM_BLOCK_WORDS;
+    EEPROM_EEOFFSET_R = address % EEPROM_BLOCK_WORDS;
+}
+
+// Returns false if the EEPROM could not recover from an interrupted
+// program or erase, it must not be used then
+bool initEeprom() {
+    SYSCTL_RCGCEEPROM_R |= SYSCTL_RCGCEEPROM_R0;
+    _delay_cycles(6);
+    waitEeprom();
+    if (EEPROM_EESUPP_R & (EEPROM_EESUPP_PRETRY | EEPROM_EESUPP_ERETRY)) {
+        return false;
+    }
+
+    // reset as the datasheet asks, so a recovered copy is picked up
+    SYSCTL_SREEPROM_R |= SYSCTL_SREEPROM_R0;
+    _delay_cycles(6);
+    SYSCTL_SREEPROM_R &= ~SYSCTL_SREEPROM_R0;
+    _delay_cycles(6);
+    waitEeprom();
+    return !(EEPROM_EESUPP_R & (EEPROM_EESUPP_PRETRY | EEPROM_EESUPP_ERETRY));
+}
+
+void readEeprom(uint16_t address, uint32_t *data, uint8_t count) {
+    uint8_t i;
+    seekEeprom(address);
+    for (i = 0; i < count; i++) {
+        data[i] = EEPROM_EERDWRINC_R;
+        address++;
+        // the offset wraps within a block
+        if (address % EEPROM_BLOCK_WORDS == 0) {
+            seekEeprom(address);
+        }
+    }
+}
+
+// Returns false if a word could not be written
+bool writeEeprom(uint16_t address, const uint32_t *data, uint8_t count) {
+    uint8_t i;
+    for (i = 0; i < count; i++, address++) {
+        seekEeprom(address);
+        if (EEPROM_EERDWR_R == data[i]) {
+            continue;
+        }
+        EEPROM_EERDWR_R = data[i];
+        waitEeprom();
+        if (EEPROM_EEDONE_R & EEPROM_EEDONE_NOPERM) {
+            return false;
+        }
+    }
+    return true;
+}
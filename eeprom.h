@@ -0,0 +1,34 @@
+// EEPROM Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// 2 KB on-chip EEPROM, 32 blocks of 16 words
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef EEPROM_H_
+#define EEPROM_H_
+
+// Addresses and counts are in 32-bit words
+#define EEPROM_WORDS 512
+#define EEPROM_BLOCK_WORDS 16
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+bool initEeprom();
+void readEeprom(uint16_t address, uint32_t *data, uint8_t count);
+bool writeEeprom(uint16_t address, const uint32_t *data, uint8_t count);
+
+#endif
@@ -0,0 +1,162 @@
+// Fixed-Point Real FFT
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// A length N real sequence is packed as N/2 complex points (even samples in
+// the real part, odd in the imaginary part), run through an in-place radix-2
+// decimation in time FFT, and individual real spectrum bins are recovered
+// from it on request. Every butterfly stage halves its output so nothing
+// overflows; the spectrum comes out scaled by 1 / (N / 2).
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dsp.h"
+#include "fft.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+// exp(-j 2 pi k / N) for k < N / 2 as {cos, sin} pairs, Q15
+const q15_t fftTwiddle[FFT_LENGTH] = {
+    32767, 0, 32758, 804, 32729, 1608, 32679, 2411,
+    32610, 3212, 32522, 4011, 32413, 4808, 32286, 5602,
+    32138, 6393, 31972, 7180, 31786, 7962, 31581, 8740,
+    31357, 9512, 31114, 10279, 30853, 11039, 30572, 11793,
+    30274, 12540, 29957, 13279, 29622, 14010, 29269, 14733,
+    28899, 15447, 28511, 16151, 28106, 16846, 27684, 17531,
+    27246, 18205, 26791, 18868, 26320, 19520, 25833, 20160,
+    25330, 20788, 24812, 21403, 24279, 22006, 23732, 22595,
+    23170, 23170, 22595, 23732, 22006, 24279, 21403, 24812,
+    20788, 25330, 20160, 25833, 19520, 26320, 18868, 26791,
+    18205, 27246, 17531, 27684, 16846, 28106, 16151, 28511,
+    15447, 28899, 14733, 29269, 14010, 29622, 13279, 29957,
+    12540, 30274, 11793, 30572, 11039, 30853, 10279, 31114,
+    9512, 31357, 8740, 31581, 7962, 31786, 7180, 31972,
+    6393, 32138, 5602, 32286, 4808, 32413, 4011, 32522,
+    3212, 32610, 2411, 32679, 1608, 32729, 804, 32758,
+    0, 32767, -804, 32758, -1608, 32729, -2411, 32679,
+    -3212, 32610, -4011, 32522, -4808, 32413, -5602, 32286,
+    -6393, 32138, -7180, 31972, -7962, 31786, -8740, 31581,
+    -9512, 31357, -10279, 31114, -11039, 30853, -11793, 30572,
+    -12540, 30274, -13279, 29957, -14010, 29622, -14733, 29269,
+    -15447, 28899, -16151, 28511, -16846, 28106, -17531, 27684,
+    -18205, 27246, -18868, 26791, -19520, 26320, -20160, 25833,
+    -20788, 25330, -21403, 24812, -22006, 24279, -22595, 23732,
+    -23170, 23170, -23732, 22595, -24279, 22006, -24812, 21403,
+    -25330, 20788, -25833, 20160, -26320, 19520, -26791, 18868,
+    -27246, 18205, -27684, 17531, -28106, 16846, -28511, 16151,
+    -28899, 15447, -29269, 14733, -29622, 14010, -29957, 13279,
+    -30274, 12540, -30572, 11793, -30853, 11039, -31114, 10279,
+    -31357, 9512, -31581, 8740, -31786, 7962, -31972, 7180,
+    -32138, 6393, -32286, 5602, -32413, 4808, -32522, 4011,
+    -32610, 3212, -32679, 2411, -32729, 1608, -32758, 804,
+};
+
+// Hann window, Q15
+const q15_t fftHann[FFT_LENGTH] = {
+    0, 5, 20, 44, 79, 123, 177, 241, 315, 398,
+    491, 593, 705, 827, 958, 1098, 1247, 1406, 1573, 1749,
+    1935, 2128, 2331, 2542, 2761, 2989, 3224, 3468, 3719, 3978,
+    4244, 4518, 4799, 5087, 5381, 5682, 5990, 6304, 6624, 6950,
+    7282, 7619, 7961, 8308, 8661, 9018, 9379, 9745, 10114, 10487,
+    10864, 11245, 11628, 12014, 12403, 12794, 13188, 13583, 13980, 14378,
+    14778, 15179, 15580, 15982, 16384, 16786, 17188, 17589, 17990, 18390,
+    18788, 19185, 19580, 19974, 20365, 20754, 21140, 21523, 21904, 22281,
+    22654, 23023, 23389, 23750, 24107, 24460, 24807, 25149, 25486, 25818,
+    26144, 26464, 26778, 27086, 27387, 27681, 27969, 28250, 28524, 28790,
+    29049, 29300, 29544, 29779, 30007, 30226, 30437, 30640, 30833, 31019,
+    31195, 31362, 31521, 31670, 31810, 31941, 32063, 32175, 32277, 32370,
+    32453, 32527, 32591, 32645, 32689, 32724, 32748, 32763, 32767, 32763,
+    32748, 32724, 32689, 32645, 32591, 32527, 32453, 32370, 32277, 32175,
+    32063, 31941, 31810, 31670, 31521, 31362, 31195, 31019, 30833, 30640,
+    30437, 30226, 30007, 29779, 29544, 29300, 29049, 28790, 28524, 28250,
+    27969, 27681, 27387, 27086, 26778, 26464, 26144, 25818, 25486, 25149,
+    24807, 24460, 24107, 23750, 23389, 23023, 22654, 22281, 21904, 21523,
+    21140, 20754, 20365, 19974, 19580, 19185, 18788, 18390, 17990, 17589,
+    17188, 16786, 16384, 15982, 15580, 15179, 14778, 14378, 13980, 13583,
+    13188, 12794, 12403, 12014, 11628, 11245, 10864, 10487, 10114, 9745,
+    9379, 9018, 8661, 8308, 7961, 7619, 7282, 6950, 6624, 6304,
+    5990, 5682, 5381, 5087, 4799, 4518, 4244, 3978, 3719, 3468,
+    3224, 2989, 2761, 2542, 2331, 2128, 1935, 1749, 1573, 1406,
+    1247, 1098, 958, 827, 705, 593, 491, 398, 315, 241,
+    177, 123, 79, 44, 20, 5,
+};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Complex data is interleaved {re, im}
+void runRfftQ15(q15_t *data) {
+    uint16_t i, j, k, len;
+
+    // bit reverse reorder
+    j = 0;
+    for (i = 0; i < FFT_HALF - 1; i++) {
+        if (i < j) {
+            q15_t re = data[2 * i];
+            q15_t im = data[2 * i + 1];
+            data[2 * i] = data[2 * j];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j] = re;
+            data[2 * j + 1] = im;
+        }
+        k = FFT_HALF / 2;
+        while (k <= j) {
+            j -= k;
+            k >>= 1;
+        }
+        j += k;
+    }
+
+    // butterflies, twiddle W_half^m = W_N^(2m)
+    for (len = 2; len <= FFT_HALF; len <<= 1) {
+        uint16_t half = len / 2;
+        uint16_t step = 2 * (FFT_HALF / len);
+        for (i = 0; i < FFT_HALF; i += len) {
+            for (j = 0; j < half; j++) {
+                int32_t c = fftTwiddle[2 * j * step];
+                int32_t s = fftTwiddle[2 * j * step + 1];
+                q15_t *a = &data[2 * (i + j)];
+                q15_t *b = &data[2 * (i + j + half)];
+                // t = b * (c - js)
+                int32_t tr = (b[0] * c + b[1] * s) >> 15;
+                int32_t ti = (b[1] * c - b[0] * s) >> 15;
+                b[0] = (a[0] - tr) >> 1;
+                b[1] = (a[1] - ti) >> 1;
+                a[0] = (a[0] + tr) >> 1;
+                a[1] = (a[1] + ti) >> 1;
+            }
+        }
+    }
+}
+
+// Real spectrum bin k (0 < k < N / 2) from the half length complex result,
+// same scale as the complex FFT output
+void getRfftBinQ15(const q15_t *data, uint16_t k, int32_t *re, int32_t *im) {
+    const q15_t *a = &data[2 * k];
+    const q15_t *b = &data[2 * (FFT_HALF - k)];
+    // even part E = (Z[k] + conj(Z[M-k])) / 2, odd part O = (Z[k] -
+    // conj(Z[M-k])) / 2, X[k] = E - j W_N^k O
+    int32_t evenRe = (a[0] + b[0]) >> 1;
+    int32_t evenIm = (a[1] - b[1]) >> 1;
+    int32_t oddRe = (a[0] - b[0]) >> 1;
+    int32_t oddIm = (a[1] + b[1]) >> 1;
+    int32_t c = fftTwiddle[2 * k];
+    int32_t s = fftTwiddle[2 * k + 1];
+    *re = evenRe + ((c * oddIm - s * oddRe) >> 15);
+    *im = evenIm - ((c * oddRe + s * oddIm) >> 15);
+}
@@ -0,0 +1,32 @@
+// Fixed-Point Real FFT
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef FFT_H_
+#define FFT_H_
+
+// Real input length; the work is a half length complex FFT
+#define FFT_LENGTH 256
+#define FFT_HALF (FFT_LENGTH / 2)
+
+extern const q15_t fftHann[FFT_LENGTH];
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void runRfftQ15(q15_t *data);
+void getRfftBinQ15(const q15_t *data, uint16_t k, int32_t *re, int32_t *im);
+
+#endif
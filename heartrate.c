@@ -0,0 +1,151 @@
+// Spectral Heart Rate Estimator
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// Keeps the last FFT_LENGTH PPG samples (10.24 s at 25 Hz) and once a second
+// removes the mean, scales to fill Q15, applies a Hann window and takes a
+// real FFT. The strongest bin in the heart rate band is refined with a
+// parabola through it and its neighbours. Unlike edge timing, a missed or
+// doubled comparator edge does not move the estimate.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "dsp.h"
+#include "heartrate.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+q15_t hr_work[FFT_LENGTH];
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initHeartRate(HEART_RATE *hr, uint16_t sampleHz) {
+    hr->index = 0;
+    hr->count = 0;
+    hr->sinceUpdate = 0;
+    hr->sampleHz = sampleHz;
+    hr->bpm = 0;
+    hr->valid = false;
+}
+
+uint32_t getBinPower(uint16_t k) {
+    int32_t re, im;
+    getRfftBinQ15(hr_work, k, &re, &im);
+    return (uint32_t)(re * re) + (uint32_t)(im * im);
+}
+
+void estimateHeartRate(HEART_RATE *hr) {
+    uint16_t i, n;
+    int32_t sum = 0, mean, max = 0;
+    int8_t shift = 0;
+
+    for (i = 0; i < FFT_LENGTH; i++) {
+        sum += hr->window[i];
+    }
+    mean = sum / FFT_LENGTH;
+    for (i = 0; i < FFT_LENGTH; i++) {
+        int32_t d = hr->window[i] - mean;
+        if (d < 0) {
+            d = -d;
+        }
+        if (d > max) {
+            max = d;
+        }
+    }
+    if (max == 0) {
+        hr->valid = false;
+        return;
+    }
+    // block floating point: largest sample lands in [2^13, 2^14)
+    while (max >= (1 << 14)) {
+        max >>= 1;
+        shift++;
+    }
+    while (max < (1 << 13)) {
+        max <<= 1;
+        shift--;
+    }
+
+    // oldest sample first
+    n = hr->index;
+    for (i = 0; i < FFT_LENGTH; i++) {
+        int32_t d = hr->window[n] - mean;
+        d = shift >= 0 ? d >> shift : d << -shift;
+        hr_work[i] = (d * fftHann[i]) >> 15;
+        n = (n + 1) % FFT_LENGTH;
+    }
+    runRfftQ15(hr_work);
+
+    // bins whose main lobe reaches into the band, k = f * N / fs
+    uint16_t low = HR_MIN_HZ_X10 * FFT_LENGTH / (10 * hr->sampleHz);
+    uint16_t high = (HR_MAX_HZ_X10 * FFT_LENGTH + 10 * hr->sampleHz - 1) /
+                    (10 * hr->sampleHz);
+    if (low < 2) {
+        low = 2;
+    }
+    if (high > FFT_HALF - 2) {
+        high = FFT_HALF - 2;
+    }
+    uint16_t peak = low;
+    uint32_t peak_power = 0, total = 0;
+    for (i = low; i <= high; i++) {
+        uint32_t p = getBinPower(i);
+        total += p >> 6;
+        if (p > peak_power) {
+            peak_power = p;
+            peak = i;
+        }
+    }
+
+    // parabolic interpolation, offset in 1/256 of a bin
+    int64_t before = getBinPower(peak - 1);
+    int64_t after = getBinPower(peak + 1);
+    // an edge bin that still rises outward is the skirt of a rate outside
+    // the band
+    if (before > peak_power || after > peak_power) {
+        hr->valid = false;
+        return;
+    }
+    int64_t denominator = before - 2 * (int64_t)peak_power + after;
+    int32_t offset = 0;
+    if (denominator != 0) {
+        offset = (int32_t)((128 * (before - after)) / denominator);
+    }
+    int32_t bin_q8 = ((int32_t)peak << 8) + offset;
+
+    hr->bpm = 60.0f * bin_q8 * hr->sampleHz / (FFT_LENGTH * 256.0f);
+    // the peak has to stand well above the average bin of the band
+    hr->valid = (peak_power >> 6) > HR_PEAK_RATIO * (total / (high - low + 1));
+}
+
+// Add one PPG sample, returns true when a new estimate was made
+bool addHeartRateSample(HEART_RATE *hr, int32_t sample) {
+    hr->window[hr->index] = sample;
+    hr->index = (hr->index + 1) % FFT_LENGTH;
+    if (hr->count < FFT_LENGTH) {
+        hr->count++;
+    }
+    hr->sinceUpdate++;
+    if (hr->count < FFT_LENGTH || hr->sinceUpdate < hr->sampleHz) {
+        return false;
+    }
+    hr->sinceUpdate = 0;
+    estimateHeartRate(hr);
+    return true;
+}
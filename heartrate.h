@@ -0,0 +1,45 @@
+// Spectral Heart Rate Estimator
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef HEARTRATE_H_
+#define HEARTRATE_H_
+
+#include "fft.h"
+
+// Search band in Hz (30 to 240 BPM)
+#define HR_MIN_HZ_X10 5
+#define HR_MAX_HZ_X10 40
+
+// Peak power over the mean power of the band for a valid estimate
+#define HR_PEAK_RATIO 8
+
+typedef struct _HEART_RATE {
+    int32_t window[FFT_LENGTH];  // circular, oldest at index once full
+    uint16_t index;
+    uint16_t count;
+    uint16_t sinceUpdate;
+    uint16_t sampleHz;
+    float bpm;
+    bool valid;
+} HEART_RATE;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initHeartRate(HEART_RATE *hr, uint16_t sampleHz);
+bool addHeartRateSample(HEART_RATE *hr, int32_t sample);
+
+#endif
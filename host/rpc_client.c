@@ -0,0 +1,332 @@
+// Binary RPC Host Client Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: host (POSIX serial port or pty)
+// Target uC:       - (runs on the host, talks to the monitor firmware)
+// System Clock:    -
+
+// One RPC_CLIENT per monitor. The descriptor is switched to raw,
+// non-blocking mode and nothing here ever waits: requests are queued and
+// sent by pollRpcClient(), which a gateway calls whenever poll() reports the
+// events from getRpcClientEvents() on any of its monitors. Up to
+// RPC_CLIENT_WINDOW requests may be in flight, and each response is matched
+// to its request by id. Stream samples and alarm changes arrive decoded
+// through their own callbacks.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#define _DEFAULT_SOURCE  // cfmakeraw()
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "rpc_client.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint64_t getMilliseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+bool queueRpcBytes(RPC_CLIENT *client, const uint8_t *bytes, uint16_t n) {
+    if (client->txEnd + n > RPC_CLIENT_TX_SIZE) {
+        // slide the unsent bytes to the front
+        memmove(client->tx, &client->tx[client->txStart],
+                client->txEnd - client->txStart);
+        client->txEnd -= client->txStart;
+        client->txStart = 0;
+        if (client->txEnd + n > RPC_CLIENT_TX_SIZE) {
+            return false;
+        }
+    }
+    memcpy(&client->tx[client->txEnd], bytes, n);
+    client->txEnd += n;
+    return true;
+}
+
+// Write as much as the descriptor takes, false on an I/O error
+bool flushRpcClient(RPC_CLIENT *client) {
+    ssize_t n;
+    while (client->txStart < client->txEnd) {
+        n = write(client->fd, &client->tx[client->txStart],
+                  client->txEnd - client->txStart);
+        if (n < 0) {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+        client->txStart += n;
+    }
+    client->txStart = client->txEnd = 0;
+    return true;
+}
+
+// Switches the descriptor to non-blocking and a terminal to raw mode, so
+// frame bytes are neither echoed, translated nor held for a line, and
+// queues the preamble that moves the monitor from its text shell to frames
+bool openRpcClient(RPC_CLIENT *client, int fd, RPC_SAMPLE_CALLBACK onSample,
+                   void *sampleContext) {
+    struct termios raw;
+    int flags = fcntl(fd, F_GETFL);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0) {
+        return false;
+    }
+    if (isatty(fd)) {
+        if (tcgetattr(fd, &raw) < 0) {
+            return false;
+        }
+        cfmakeraw(&raw);
+        if (tcsetattr(fd, TCSANOW, &raw) < 0) {
+            return false;
+        }
+    }
+    memset(client, 0, sizeof(*client));
+    client->fd = fd;
+    client->nextId = 1;
+    client->onSample = onSample;
+    client->sampleContext = sampleContext;
+    initRpcParser(&client->parser);
+    queueRpcBytes(client, rpcPreamble, RPC_PREAMBLE_LENGTH);
+    return flushRpcClient(client);
+}
+
+// Alarm events are ignored until a callback is set
+void setRpcAlarmCallback(RPC_CLIENT *client, RPC_ALARM_CALLBACK onAlarm,
+                         void *alarmContext) {
+    client->onAlarm = onAlarm;
+    client->alarmContext = alarmContext;
+}
+
+// Sets the request id and queues the frame, returns the id or -1 when the
+// window or transmit buffer is full or the descriptor failed
+int sendRpcRequest(RPC_CLIENT *client, RPC_FRAME *request,
+                   RPC_RESPONSE_CALLBACK callback, void *context) {
+    uint8_t bytes[RPC_MAX_FRAME];
+    RPC_PENDING *slot = NULL;
+    uint16_t n, start;
+    uint8_t i;
+    for (i = 0; i < RPC_CLIENT_WINDOW && slot == NULL; i++) {
+        if (!client->pending[i].used) {
+            slot = &client->pending[i];
+        }
+    }
+    if (slot == NULL) {
+        return -1;
+    }
+    // id 0 marks unrequested frames
+    request->id = client->nextId;
+    client->nextId = client->nextId == 255 ? 1 : client->nextId + 1;
+    n = encodeRpcFrame(request, bytes);
+    if (!queueRpcBytes(client, bytes, n)) {
+        return -1;
+    }
+    start = client->txEnd - n;
+    slot->used = true;
+    slot->id = request->id;
+    slot->deadline = getMilliseconds() + RPC_CLIENT_TIMEOUT_MS;
+    slot->callback = callback;
+    slot->context = context;
+    if (!flushRpcClient(client)) {
+        // the caller is told this request failed, so none of it may go
+        // out on a later flush; a part already written is left to the
+        // monitor's CRC check
+        client->txEnd = client->txStart > start ? client->txStart : start;
+        slot->used = false;
+        return -1;
+    }
+    return request->id;
+}
+
+// Events to wait for in poll()
+short getRpcClientEvents(const RPC_CLIENT *client) {
+    return POLLIN | (client->txStart < client->txEnd ? POLLOUT : 0);
+}
+
+void decodeRpcReadings(const RPC_FRAME *frame, RPC_READINGS *readings) {
+    int32_t value, other;
+    memset(readings, 0, sizeof(*readings));
+    if (getRpcValue(frame, RPC_PULSE, &value)) {
+        readings->present |= RPC_READ_PULSE;
+        readings->pulse = value / 65536.0f;
+    }
+    if (getRpcValue(frame, RPC_SPECTRAL, &value)) {
+        readings->present |= RPC_READ_SPECTRAL;
+        readings->spectral = value / 65536.0f;
+    }
+    if (getRpcValue(frame, RPC_BREATH, &value)) {
+        readings->present |= RPC_READ_RESPIRATION;
+        readings->breath = value / 65536.0f;
+    }
+    if (getRpcValue(frame, RPC_AUTOCORR, &value) &&
+        getRpcValue(frame, RPC_CONFIDENCE, &other)) {
+        readings->present |= RPC_READ_AUTOCORR;
+        readings->autocorr = value / 65536.0f;
+        readings->confidence = other / 65536.0f;
+    }
+    if (getRpcValue(frame, RPC_LIGHT_ON, &value) &&
+        getRpcValue(frame, RPC_LIGHT_OFF, &other)) {
+        readings->present |= RPC_READ_LIGHT;
+        readings->lightOn = value;
+        readings->lightOff = other;
+    }
+    if (getRpcValue(frame, RPC_STRAIN, &value)) {
+        readings->present |= RPC_READ_STRAIN;
+        readings->strain = value;
+    }
+    if (getRpcValue(frame, RPC_ALARM, &value)) {
+        readings->present |= RPC_READ_ALARM;
+        readings->alarm = value;
+    }
+}
+
+void decodeRpcAlarm(const RPC_FRAME *frame, RPC_ALARM_REPORT *alarm) {
+    int32_t value = 0;
+    getRpcValue(frame, RPC_RULE, &value);
+    alarm->rule = value;
+    getRpcValue(frame, RPC_VITAL, &value);
+    alarm->vital = value;
+    getRpcValue(frame, RPC_KIND, &value);
+    alarm->kind = value;
+    getRpcValue(frame, RPC_PRIORITY, &value);
+    alarm->priority = value;
+    getRpcValue(frame, RPC_ACTIVE, &value);
+    alarm->active = value;
+    getRpcValue(frame, RPC_VALUE, &value);
+    alarm->value = value / 65536.0f;
+}
+
+void dispatchRpcFrame(RPC_CLIENT *client, const RPC_FRAME *frame) {
+    RPC_PENDING done;
+    RPC_READINGS sample;
+    RPC_ALARM_REPORT alarm;
+    int32_t status;
+    uint8_t i;
+    if (frame->opcode == RPC_SAMPLE_EVENT) {
+        if (client->onSample) {
+            decodeRpcReadings(frame, &sample);
+            client->onSample(client->sampleContext, &sample);
+        }
+        return;
+    }
+    if (frame->opcode == RPC_ALARM_EVENT) {
+        if (client->onAlarm) {
+            decodeRpcAlarm(frame, &alarm);
+            client->onAlarm(client->alarmContext, &alarm);
+        }
+        return;
+    }
+    if (!(frame->opcode & RPC_RESPONSE) ||
+        !getRpcValue(frame, RPC_STATUS, &status)) {
+        return;
+    }
+    for (i = 0; i < RPC_CLIENT_WINDOW; i++) {
+        if (client->pending[i].used && client->pending[i].id == frame->id) {
+            // free the slot first so the callback can send again
+            done = client->pending[i];
+            client->pending[i].used = false;
+            if (done.callback) {
+                done.callback(done.context, status, frame);
+            }
+            return;
+        }
+    }
+}
+
+// Sends queued bytes, handles everything received and times out lost
+// requests, false on an I/O error or when the monitor hung up
+bool pollRpcClient(RPC_CLIENT *client) {
+    RPC_PENDING done;
+    uint8_t bytes[64];
+    uint64_t now;
+    ssize_t n, i;
+    uint8_t j;
+    if (!flushRpcClient(client)) {
+        return false;
+    }
+    while ((n = read(client->fd, bytes, sizeof(bytes))) > 0) {
+        for (i = 0; i < n; i++) {
+            if (addRpcByte(&client->parser, bytes[i])) {
+                dispatchRpcFrame(client, &client->parser.frame);
+            }
+        }
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        return false;
+    }
+    now = getMilliseconds();
+    for (j = 0; j < RPC_CLIENT_WINDOW; j++) {
+        if (client->pending[j].used && now >= client->pending[j].deadline) {
+            done = client->pending[j];
+            client->pending[j].used = false;
+            if (done.callback) {
+                done.callback(done.context, RPC_TIMEOUT, NULL);
+            }
+        }
+    }
+    return true;
+}
+
+int requestRpcVitals(RPC_CLIENT *client, RPC_RESPONSE_CALLBACK callback,
+                     void *context) {
+    RPC_FRAME request;
+    initRpcFrame(&request, 0, RPC_GET_VITALS);
+    return sendRpcRequest(client, &request, callback, context);
+}
+
+// channel 0 pulse, 1 breath
+int requestRpcAlarm(RPC_CLIENT *client, uint8_t channel, float min, float max,
+                    RPC_RESPONSE_CALLBACK callback, void *context) {
+    RPC_FRAME request;
+    initRpcFrame(&request, 0, RPC_SET_ALARM);
+    putRpcValue(&request, RPC_CHANNEL, channel, 1);
+    putRpcValue(&request, RPC_MIN, (int32_t)(min * 65536.0f), 4);
+    putRpcValue(&request, RPC_MAX, (int32_t)(max * 65536.0f), 4);
+    return sendRpcRequest(client, &request, callback, context);
+}
+
+// fields are RPC_READ_PULSE ... RPC_READ_ALARM bits, hz 1 to 100
+int requestRpcStream(RPC_CLIENT *client, uint8_t fields, uint8_t hz,
+                     RPC_RESPONSE_CALLBACK callback, void *context) {
+    RPC_FRAME request;
+    initRpcFrame(&request, 0, RPC_START_STREAM);
+    putRpcValue(&request, RPC_FIELDS, fields, 1);
+    putRpcValue(&request, RPC_RATE, hz, 1);
+    return sendRpcRequest(client, &request, callback, context);
+}
+
+int requestRpcStreamStop(RPC_CLIENT *client, RPC_RESPONSE_CALLBACK callback,
+                         void *context) {
+    RPC_FRAME request;
+    initRpcFrame(&request, 0, RPC_STOP_STREAM);
+    return sendRpcRequest(client, &request, callback, context);
+}
+
+int requestRpcStats(RPC_CLIENT *client, RPC_RESPONSE_CALLBACK callback,
+                    void *context) {
+    RPC_FRAME request;
+    initRpcFrame(&request, 0, RPC_GET_STATS);
+    return sendRpcRequest(client, &request, callback, context);
+}
+
+// Returns the monitor to its text shell once answered
+int requestRpcExit(RPC_CLIENT *client, RPC_RESPONSE_CALLBACK callback,
+                   void *context) {
+    RPC_FRAME request;
+    initRpcFrame(&request, 0, RPC_EXIT);
+    return sendRpcRequest(client, &request, callback, context);
+}
@@ -0,0 +1,124 @@
+// Binary RPC Host Client Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: host (POSIX serial port or pty)
+// Target uC:       - (runs on the host, talks to the monitor firmware)
+// System Clock:    -
+
+// Build with the firmware framing code, for example:
+//   cc -I.. -c rpc_client.c ../rpc.c
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef RPC_CLIENT_H_
+#define RPC_CLIENT_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rpc.h"
+
+// Requests in flight per monitor, the monitor queues received bytes in a
+// UART0_RX_SIZE ring, room for this many frames of RPC_MAX_FRAME bytes
+#define RPC_CLIENT_WINDOW 4
+#define RPC_CLIENT_TX_SIZE 256
+#define RPC_CLIENT_TIMEOUT_MS 500
+
+// RPC_FIELDS bits, also set in RPC_READINGS.present
+#define RPC_READ_PULSE 1
+#define RPC_READ_RESPIRATION 2
+#define RPC_READ_LIGHT 4
+#define RPC_READ_STRAIN 8
+#define RPC_READ_ALARM 16
+#define RPC_READ_SPECTRAL 32
+#define RPC_READ_AUTOCORR 64
+
+// Decoded vitals response or stream sample
+typedef struct _RPC_READINGS {
+    uint8_t present;  // RPC_READ_* bits
+    float pulse;
+    float spectral;
+    float breath;
+    float autocorr;
+    float confidence;
+    uint16_t lightOn;
+    uint16_t lightOff;
+    int32_t strain;
+    uint8_t alarm;
+} RPC_READINGS;
+
+// Decoded alarm event
+typedef struct _RPC_ALARM_REPORT {
+    uint8_t rule;
+    uint8_t vital;  // 0 pulse, 1 breath
+    uint8_t kind;   // 0 low, 1 high, 2 rate, 3 loss
+    uint8_t priority;
+    bool active;
+    float value;
+} RPC_ALARM_REPORT;
+
+// response is NULL if the request timed out, status is then RPC_TIMEOUT
+#define RPC_TIMEOUT 0xFF
+typedef void (*RPC_RESPONSE_CALLBACK)(void *context, uint8_t status,
+                                      const RPC_FRAME *response);
+typedef void (*RPC_SAMPLE_CALLBACK)(void *context,
+                                    const RPC_READINGS *sample);
+typedef void (*RPC_ALARM_CALLBACK)(void *context,
+                                   const RPC_ALARM_REPORT *alarm);
+
+typedef struct _RPC_PENDING {
+    bool used;
+    uint8_t id;
+    uint64_t deadline;  // ms, CLOCK_MONOTONIC
+    RPC_RESPONSE_CALLBACK callback;
+    void *context;
+} RPC_PENDING;
+
+typedef struct _RPC_CLIENT {
+    int fd;
+    RPC_PARSER parser;
+    uint8_t nextId;
+    RPC_PENDING pending[RPC_CLIENT_WINDOW];
+    uint8_t tx[RPC_CLIENT_TX_SIZE];
+    uint16_t txStart;
+    uint16_t txEnd;
+    RPC_SAMPLE_CALLBACK onSample;
+    void *sampleContext;
+    RPC_ALARM_CALLBACK onAlarm;
+    void *alarmContext;
+} RPC_CLIENT;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+bool openRpcClient(RPC_CLIENT *client, int fd, RPC_SAMPLE_CALLBACK onSample,
+                   void *sampleContext);
+void setRpcAlarmCallback(RPC_CLIENT *client, RPC_ALARM_CALLBACK onAlarm,
+                         void *alarmContext);
+int sendRpcRequest(RPC_CLIENT *client, RPC_FRAME *request,
+                   RPC_RESPONSE_CALLBACK callback, void *context);
+short getRpcClientEvents(const RPC_CLIENT *client);
+bool pollRpcClient(RPC_CLIENT *client);
+void decodeRpcReadings(const RPC_FRAME *frame, RPC_READINGS *readings);
+
+int requestRpcVitals(RPC_CLIENT *client, RPC_RESPONSE_CALLBACK callback,
+                     void *context);
+int requestRpcAlarm(RPC_CLIENT *client, uint8_t channel, float min, float max,
+                    RPC_RESPONSE_CALLBACK callback, void *context);
+int requestRpcStream(RPC_CLIENT *client, uint8_t fields, uint8_t hz,
+                     RPC_RESPONSE_CALLBACK callback, void *context);
+int requestRpcStreamStop(RPC_CLIENT *client, RPC_RESPONSE_CALLBACK callback,
+                         void *context);
+int requestRpcStats(RPC_CLIENT *client, RPC_RESPONSE_CALLBACK callback,
+                    void *context);
+int requestRpcExit(RPC_CLIENT *client, RPC_RESPONSE_CALLBACK callback,
+                   void *context);
+
+#endif
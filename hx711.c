@@ -0,0 +1,353 @@
+// HX711 Strain Gauge Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// HX711_SSI = 1 (default):
+//   HX711 PD_SCK on PD0 (SSI1Clk)
+//   HX711 DOUT on PD2 (SSI1Rx, GPIO falling edge interrupt while idle)
+// HX711_SSI = 0, for boards where SSI1 is taken:
+//   HX711 PD_SCK on PD6, clocked by TIMER4A one-shot steps
+//   HX711 DOUT on PE2 (GPIO falling edge interrupt while idle)
+// HX711_SSI = 0 and HX711_COUNT = 2 to 8, several gauges on one clock:
+//   HX711 PD_SCK of every chip on PD6
+//   HX711 DOUT of gauge n on PBn (GPIO falling edge interrupts while idle)
+
+// DOUT falling low means a conversion is ready; hx711DoutIsr starts the
+// read and hx711ClockIsr finishes it, whichever back end is built. The
+// ready edge is timestamped with the DWT cycle counter, so samples carry
+// their own timing and nothing assumes the exact HX711 rate.
+//
+// The 1 to 3 pulses after the data select the input and gain of the next
+// conversion, so each sample is reported with the setting that was chosen
+// one read earlier.
+//
+// SSI: PD2 is handed to SSI1, which clocks out the 24 data bits and the gain
+// select pulses as equal sized SPI mode 1 frames (clock idles low, data
+// sampled on the falling edge) at 1 MHz. The end of transmission interrupt
+// collects the frames and gives PD2 back to the GPIO so the next ready edge
+// can be seen.
+//
+// Timer: each TIMER4A timeout is one PD_SCK pulse (raise, read, lower) and
+// re-arms the one-shot until all pulses are sent. Nothing waits in a loop.
+// Each pulse stores the whole DOUT port as one byte, bit n from gauge n, and
+// the 24 bytes are turned into per-gauge samples with three 8 x 8 bit
+// transposes. The cost per pulse and per read is the same for 1 or 8
+// gauges. With several gauges the read starts once every DOUT is low; the
+// chips hold a finished conversion until it is clocked out.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "bits.h"
+#include "cycles.h"
+#include "hx711.h"
+#include "tm4c123gh6pm.h"
+
+// 24 data bits, then 1 to 3 pulses selecting input and gain for the next
+// conversion
+#define HX711_DATA_BITS 24
+
+#if HX711_SSI
+// PortD masks
+#define SCK_MASK 1
+#define DOUT_MASK 4
+
+// Pulses are sent as equal frames of 4 to 16 bits: 25 = 5 x 5,
+// 26 = 2 x 13, 27 = 3 x 9
+typedef struct _HX711_FRAMING {
+    uint8_t frames;
+    uint8_t bits;
+} HX711_FRAMING;
+
+// 40 MHz / (2 * (1 + 19)) = 1 MHz PD_SCK
+#define HX711_CPSDVSR 2
+#define HX711_SCR 19
+#else
+// PortD masks
+#define SCK_MASK 64
+
+#define SCK                                                                \
+    (*((volatile uint32_t *)(0x42000000 + (0x400073FC - 0x40000000) * 32 + \
+                             6 * 4)))
+
+#if HX711_COUNT == 1
+// PortE masks
+#define DOUT_MASK 4
+
+// DOUT lines as one byte, bit n from gauge n
+#define DOUT_LINES                                                         \
+    (*((volatile uint32_t *)(0x42000000 + (0x400243FC - 0x40000000) * 32 + \
+                             2 * 4)))
+#define DOUT_GPIO_R SYSCTL_RCGCGPIO_R4
+#define DOUT_DIR_R GPIO_PORTE_DIR_R
+#define DOUT_DEN_R GPIO_PORTE_DEN_R
+#define DOUT_IM_R GPIO_PORTE_IM_R
+#define DOUT_IS_R GPIO_PORTE_IS_R
+#define DOUT_IBE_R GPIO_PORTE_IBE_R
+#define DOUT_IEV_R GPIO_PORTE_IEV_R
+#define DOUT_ICR_R GPIO_PORTE_ICR_R
+#define DOUT_INT INT_GPIOE
+#else
+// PortB masks
+#define DOUT_MASK ((1 << HX711_COUNT) - 1)
+
+#define DOUT_LINES (GPIO_PORTB_DATA_R & DOUT_MASK)
+#define DOUT_GPIO_R SYSCTL_RCGCGPIO_R1
+#define DOUT_DIR_R GPIO_PORTB_DIR_R
+#define DOUT_DEN_R GPIO_PORTB_DEN_R
+#define DOUT_IM_R GPIO_PORTB_IM_R
+#define DOUT_IS_R GPIO_PORTB_IS_R
+#define DOUT_IBE_R GPIO_PORTB_IBE_R
+#define DOUT_IEV_R GPIO_PORTB_IEV_R
+#define DOUT_ICR_R GPIO_PORTB_ICR_R
+#define DOUT_INT INT_GPIOB
+#endif
+
+// 10 us between PD_SCK pulses
+#define HX711_STEP_CLOCKS 400
+#endif
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+HX711_CALLBACK hx711_callback = 0;
+
+// Settings to cycle through and the one the running conversion uses
+HX711_GAIN hx711_sequence[2] = {HX711_A128, HX711_A128};
+uint8_t hx711_index = 0;
+bool hx711_alternate = false;
+HX711_GAIN hx711_converting = HX711_A128;
+HX711_GAIN hx711_selecting = HX711_A128;
+uint32_t hx711_time = 0;
+
+#if HX711_SSI
+const HX711_FRAMING hx711_framing[3] = {{5, 5}, {2, 13}, {3, 9}};
+#else
+uint8_t hx711_pulse = 0;
+uint8_t hx711_lines[HX711_DATA_BITS];  // DOUT port per data pulse, MSB first
+#endif
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Convert every sample with one setting
+void setHx711Gain(HX711_GAIN gain) {
+    hx711_alternate = false;
+    hx711_sequence[0] = gain;
+    hx711_sequence[1] = gain;
+}
+
+// Swap settings on every conversion, e.g. A128 and B32 to read both bridges
+void setHx711Alternate(HX711_GAIN first, HX711_GAIN second) {
+    hx711_sequence[0] = first;
+    hx711_sequence[1] = second;
+    hx711_alternate = true;
+}
+
+// Timestamp the ready edge and pick the setting to select at the end of
+// this read
+HX711_GAIN startHx711Read() {
+    hx711_time = DWT_CYCCNT;
+    if (hx711_alternate) {
+        hx711_index ^= 1;
+    } else {
+        hx711_index = 0;
+    }
+    hx711_selecting = hx711_sequence[hx711_index];
+    return hx711_selecting;
+}
+
+// Returns the setting the finished read was converted with
+HX711_GAIN finishHx711Read() {
+    HX711_GAIN gain = hx711_converting;
+    // the pulses just sent chose the setting of the next conversion
+    hx711_converting = hx711_selecting;
+    return gain;
+}
+
+// Sign extend and deliver one gauge's sample
+void deliverHx711Sample(uint8_t gauge, HX711_GAIN gain, uint32_t raw) {
+    int32_t value = (int32_t)(raw << 8) >> 8;
+    if (hx711_callback) {
+        hx711_callback(gauge, gain, value, hx711_time);
+    }
+}
+
+#if HX711_SSI
+
+void initHx711(HX711_CALLBACK callback) {
+    hx711_callback = callback;
+
+    // Enable clocks
+    SYSCTL_RCGCSSI_R |= SYSCTL_RCGCSSI_R1;
+    SYSCTL_RCGCGPIO_R |= SYSCTL_RCGCGPIO_R3;
+    _delay_cycles(3);
+
+    // PD0 is always SSI1Clk, PD2 starts as a GPIO input
+    GPIO_PORTD_DEN_R |= SCK_MASK | DOUT_MASK;
+    GPIO_PORTD_DIR_R &= ~DOUT_MASK;
+    GPIO_PORTD_AFSEL_R |= SCK_MASK;
+    GPIO_PORTD_AFSEL_R &= ~DOUT_MASK;
+    GPIO_PORTD_PCTL_R &= ~(GPIO_PCTL_PD0_M | GPIO_PCTL_PD2_M);
+    GPIO_PORTD_PCTL_R |= GPIO_PCTL_PD0_SSI1CLK | GPIO_PCTL_PD2_SSI1RX;
+
+    // Configure SSI1 as master, SPI mode 1
+    SSI1_CR1_R &= ~SSI_CR1_SSE;  // turn off SSI1 to allow re-configuration
+    SSI1_CR1_R = SSI_CR1_EOT;    // master, TX interrupt at end of transmission
+    SSI1_CC_R = SSI_CC_CS_SYSPLL;
+    SSI1_CPSR_R = HX711_CPSDVSR;
+    SSI1_CR0_R = (HX711_SCR << SSI_CR0_SCR_S) | SSI_CR0_SPH | SSI_CR0_FRF_MOTO |
+                 SSI_CR0_DSS_5;
+    SSI1_IM_R = 0;
+    SSI1_CR1_R |= SSI_CR1_SSE;  // turn on SSI1
+    NVIC_EN1_R |= 1 << (INT_SSI1 - 16 - 32);  // turn-on interrupt 50 (SSI1)
+
+    // DOUT falling edge (data ready)
+    GPIO_PORTD_IM_R &= ~DOUT_MASK;
+    GPIO_PORTD_IS_R &= ~DOUT_MASK;
+    GPIO_PORTD_IBE_R &= ~DOUT_MASK;
+    GPIO_PORTD_IEV_R &= ~DOUT_MASK;
+    GPIO_PORTD_ICR_R = DOUT_MASK;
+    GPIO_PORTD_IM_R |= DOUT_MASK;
+    NVIC_EN0_R |= 1 << (INT_GPIOD - 16);  // turn-on interrupt 19 (GPIOD)
+}
+
+// Conversion ready, start clocking it out
+void hx711DoutIsr() {
+    const HX711_FRAMING *framing = &hx711_framing[startHx711Read() - 25];
+    uint8_t i;
+    GPIO_PORTD_IM_R &= ~DOUT_MASK;
+    GPIO_PORTD_ICR_R = DOUT_MASK;
+
+    // frame size can only change while SSI1 is off
+    SSI1_CR1_R &= ~SSI_CR1_SSE;
+    SSI1_CR0_R = (SSI1_CR0_R & ~SSI_CR0_DSS_M) | (framing->bits - 1);
+    SSI1_CR1_R |= SSI_CR1_SSE;
+
+    GPIO_PORTD_AFSEL_R |= DOUT_MASK;  // hand DOUT to SSI1Rx
+    for (i = 0; i < framing->frames; i++) {
+        SSI1_DR_R = 0;
+    }
+    SSI1_IM_R |= SSI_IM_TXIM;
+}
+
+// All pulses sent, assemble the sample
+void hx711ClockIsr() {
+    const HX711_FRAMING *framing = &hx711_framing[hx711_selecting - 25];
+    uint32_t value = 0;
+    uint8_t i;
+    SSI1_IM_R &= ~SSI_IM_TXIM;
+    for (i = 0; i < framing->frames; i++) {
+        value = (value << framing->bits) | SSI1_DR_R;
+    }
+    // drop the bits clocked in during the gain select pulses
+    value >>= hx711_selecting - HX711_DATA_BITS;
+
+    GPIO_PORTD_AFSEL_R &= ~DOUT_MASK;  // back to GPIO to watch for ready
+    GPIO_PORTD_ICR_R = DOUT_MASK;
+    GPIO_PORTD_IM_R |= DOUT_MASK;
+
+    deliverHx711Sample(0, finishHx711Read(), value);
+}
+
+#else
+
+void initHx711(HX711_CALLBACK callback) {
+    hx711_callback = callback;
+
+    // Enable clocks
+    SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R4;
+    SYSCTL_RCGCGPIO_R |= SYSCTL_RCGCGPIO_R3 | DOUT_GPIO_R;
+    _delay_cycles(3);
+
+    // PD_SCK output idling low, DOUT inputs
+    SCK = 0;
+    GPIO_PORTD_DIR_R |= SCK_MASK;
+    GPIO_PORTD_DEN_R |= SCK_MASK;
+    DOUT_DIR_R &= ~DOUT_MASK;
+    DOUT_DEN_R |= DOUT_MASK;
+
+    // TIMER4A one-shot, one timeout per PD_SCK pulse
+    TIMER4_CTL_R &= ~TIMER_CTL_TAEN;
+    TIMER4_CFG_R = TIMER_CFG_32_BIT_TIMER;
+    TIMER4_TAMR_R = TIMER_TAMR_TAMR_1_SHOT;
+    TIMER4_TAILR_R = HX711_STEP_CLOCKS;
+    TIMER4_IMR_R = TIMER_IMR_TATOIM;
+    NVIC_EN2_R |= 1 << (INT_TIMER4A - 16 - 64);  // turn-on interrupt 86
+
+    // DOUT falling edges (data ready)
+    DOUT_IM_R &= ~DOUT_MASK;
+    DOUT_IS_R &= ~DOUT_MASK;
+    DOUT_IBE_R &= ~DOUT_MASK;
+    DOUT_IEV_R &= ~DOUT_MASK;
+    DOUT_ICR_R = DOUT_MASK;
+    DOUT_IM_R |= DOUT_MASK;
+    NVIC_EN0_R |= 1 << (DOUT_INT - 16);  // turn-on GPIOE or GPIOB interrupt
+}
+
+// Conversion ready, schedule the first pulse once every gauge is ready
+void hx711DoutIsr() {
+    DOUT_ICR_R = DOUT_MASK;
+    if (DOUT_LINES != 0) {
+        return;
+    }
+    startHx711Read();
+    DOUT_IM_R &= ~DOUT_MASK;
+    hx711_pulse = 0;
+    TIMER4_CTL_R |= TIMER_CTL_TAEN;
+}
+
+// One PD_SCK pulse per timeout
+void hx711ClockIsr() {
+    uint8_t lines;
+    uint8_t columns[3][8];
+    HX711_GAIN gain;
+    uint8_t g;
+    TIMER4_ICR_R = TIMER_ICR_TATOCINT;
+
+    SCK = 1;
+    _delay_cycles(8);  // DOUT settles 0.1 us after the rising edge
+    lines = DOUT_LINES;
+    SCK = 0;
+
+    if (hx711_pulse < HX711_DATA_BITS) {
+        hx711_lines[hx711_pulse] = lines;
+    }
+    hx711_pulse++;
+
+    if (hx711_pulse < hx711_selecting) {
+        TIMER4_CTL_R |= TIMER_CTL_TAEN;  // re-arm for the next pulse
+        return;
+    }
+
+    DOUT_ICR_R = DOUT_MASK;  // watch for the next ready edge
+    DOUT_IM_R |= DOUT_MASK;
+
+    // rows are pulses, columns are gauges; gauge n ends up in columns[][7-n]
+    transposeBits8x8(&hx711_lines[0], columns[0]);
+    transposeBits8x8(&hx711_lines[8], columns[1]);
+    transposeBits8x8(&hx711_lines[16], columns[2]);
+    gain = finishHx711Read();
+    for (g = 0; g < HX711_COUNT; g++) {
+        deliverHx711Sample(g, gain,
+                           ((uint32_t)columns[0][7 - g] << 16) |
+                               ((uint32_t)columns[1][7 - g] << 8) |
+                               columns[2][7 - g]);
+    }
+}
+
+#endif
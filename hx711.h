@@ -0,0 +1,72 @@
+// HX711 Strain Gauge Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// HX711_SSI = 1 (default):
+//   HX711 PD_SCK on PD0 (SSI1Clk)
+//   HX711 DOUT on PD2 (SSI1Rx, GPIO falling edge interrupt while idle)
+// HX711_SSI = 0, for boards where SSI1 is taken:
+//   HX711 PD_SCK on PD6, clocked by TIMER4A one-shot steps
+//   HX711 DOUT on PE2 (GPIO falling edge interrupt while idle)
+// HX711_SSI = 0 and HX711_COUNT = 2 to 8, several gauges on one clock:
+//   HX711 PD_SCK of every chip on PD6
+//   HX711 DOUT of gauge n on PBn (GPIO falling edge interrupts while idle)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef HX711_H_
+#define HX711_H_
+
+#ifndef HX711_SSI
+#define HX711_SSI 1
+#endif
+
+// Gauges sharing PD_SCK, more than one needs the timer back end
+#ifndef HX711_COUNT
+#define HX711_COUNT 1
+#endif
+
+#if HX711_SSI && HX711_COUNT > 1
+#error "HX711_COUNT > 1 needs HX711_SSI = 0"
+#endif
+
+// Output rate set by the RATE pin: low = 10, high = 80 samples per second
+#ifndef HX711_SPS
+#define HX711_SPS 10
+#endif
+
+// Input and gain, numbered by the PD_SCK pulses that select them
+typedef enum _HX711_GAIN {
+    HX711_A128 = 25,  // channel A, gain 128 (power-up default)
+    HX711_B32 = 26,   // channel B, gain 32
+    HX711_A64 = 27    // channel A, gain 64
+} HX711_GAIN;
+
+// Called from interrupt context with each finished conversion, gauge is
+// 0 to HX711_COUNT - 1, value is the signed 24-bit result, gain the setting
+// it was converted with and time the system clock count when DOUT signalled
+// it ready
+typedef void (*HX711_CALLBACK)(uint8_t gauge, HX711_GAIN gain, int32_t value,
+                               uint32_t time);
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initHx711(HX711_CALLBACK callback);
+void setHx711Gain(HX711_GAIN gain);
+void setHx711Alternate(HX711_GAIN first, HX711_GAIN second);
+void hx711DoutIsr();
+void hx711ClockIsr();
+
+#endif
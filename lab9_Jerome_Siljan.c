@@ -5,7 +5,9 @@
 //   COM port Configured to 115,200 baud, 8N1
 // Frequency counter and timer input:
 //   SIGNAL_IN on PC6 (WT1CCP0)
-// Red LED on PC7
+// PPG LED on PC7 (WT1CCP1), PWM driven
+// Phototransistor on AIN3 (PE0), ADC triggered by TIMER5A
+// HX711 PD_SCK on PD0 (SSI1Clk), DOUT on PD2 (SSI1Rx)
 
 // Device includes, defines, and assembler directives
 #include <inttypes.h>
@@ -15,10 +17,28 @@
 #include <string.h>
 
 #include "adc0.h"
+#include "alarm.h"
+#include "bench.h"
+#include "breath.h"
+#include "capture.h"
 #include "clock.h"
+#include "config.h"
+#include "cycles.h"
+#include "dsp.h"
+#include "eeprom.h"
+#include "heartrate.h"
+#include "hx711.h"
+#include "number.h"
+#include "ppg.h"
+#include "presence.h"
+#include "respiration.h"
+#include "ring.h"
+#include "rpc.h"
+#include "server.h"
+#include "strain.h"
 #include "tm4c123gh6pm.h"
+#include "trace.h"
 #include "uart0.h"
-#include "wait.h"
 
 #define RED_LED                                                            \
     (*((volatile uint32_t *)(0x42000000 + (0x400253FC - 0x40000000) * 32 + \
@@ -28,7 +48,6 @@
                              2 * 4)))
 // PortC masks
 #define FREQ_IN_MASK 64
-#define RED_LED_MASK 128
 
 // PortE masks
 #define AIN3_MASK 1
@@ -39,72 +58,157 @@
 
 // bpm averaging consts
 #define BPM_NUM 5
-#define NUM_DIST 10
 
 // shell vars
 #define MAX_CHARS 80
 #define MAX_FIELDS 5
 
-// SPI
-#define DATA_MASK 4
-#define CLK_MASK 64
-
-#define CLK                                                                \
-    (*((volatile uint32_t *)(0x42000000 + (0x400073FC - 0x40000000) * 32 + \
-                             6 * 4)))
-
-#define DATA                                                               \
-    (*((volatile uint32_t *)(0x42000000 + (0x400243FC - 0x40000000) * 32 + \
-                             2 * 4)))
-
 // Global variables
 bool pulse_active = false;
-bool timeMode = false;
-uint32_t frequency = 0;
-uint32_t time = 0;
-uint32_t finger_missing_count = 0;
+
+// finger presence, thresholds in ADC counts and timing in 10 Hz samples
+const PRESENCE_CONFIG presence_config = {1500, 60, 40, 5, 30};
+PRESENCE presence;
+uint16_t light_on_last = 0;
+uint16_t light_off_last = 0;
+
+// spectral heart rate from the demodulated PPG waveform
+HEART_RATE heart_rate;
 
 float bpm_array[BPM_NUM];
 uint32_t bpm_index = 0;
-uint32_t bpm_upper = 150;
-uint32_t bpm_lower = 40;
+float bpm_average = 0;
+// alarm limits as the Q16.16 values entered, saved to EEPROM unchanged
+int32_t bpm_upper;
+int32_t bpm_lower;
+
+STRAIN strain;
+volatile int32_t strain_counts = 0;
+
+// breath detection on strain gauge samples decimated to 10 Hz: 1.5 Hz
+// Butterworth low-pass, 6.4 s baseline, 1 s to 30 s breaths timed in
+// system clocks
+#define BREATH_SAMPLE_HZ 10
+#define CLOCKS_PER_SECOND 40000000
+const q31_t breath_low_pass[BIQUAD_COEFFS] = {140774468, 281548936, 140774468,
+                                              802932516, -292288564};
+const BREATH_CONFIG breath_config = {breath_low_pass,
+                                     HX711_SPS / BREATH_SAMPLE_HZ,
+                                     6,
+                                     500,
+                                     CLOCKS_PER_SECOND,
+                                     30 * CLOCKS_PER_SECOND};
+BREATH breath;
+
+// breath rate from the autocorrelation of the breath signal
+RESPIRATION respiration;
 
-char str[MAX_CHARS + 1];
-
-uint32_t prev_breath;
-uint32_t up = 0;
-uint32_t down = 0;
-int32_t diff = 0;
 float breath_time = 0;
-float num_samples;
-uint32_t breath_upper = 5;
-uint32_t breath_lower = 20;
+
+// handed from the HX711 interrupt to the main loop: the baseline-free
+// signal at the respiration rate and each finished breath
+typedef struct _BREATH_INTERVAL {
+    uint32_t interval;
+    uint32_t time;
+} BREATH_INTERVAL;
+SPSC_RING(SAMPLE_RING, SampleRing, int32_t, 16)
+SPSC_RING(INTERVAL_RING, IntervalRing, BREATH_INTERVAL, 4)
+SAMPLE_RING breath_samples;
+INTERVAL_RING breath_intervals;
+int32_t breath_upper;  // Q16.16
+int32_t breath_lower;
+
+// alarm rules, the rows of a vital kept together; the low and high limits
+// are the ones the alarm command sets
+#define VITAL_PULSE 0
+#define VITAL_BREATH 1
+#define RULE_PULSE_LOW 0
+#define RULE_PULSE_HIGH 1
+#define RULE_BREATH_LOW 4
+#define RULE_BREATH_HIGH 5
+const ALARM_RULE alarm_rules[] = {
+    // vital, kind, priority, limit, hysteresis, debounce
+    {VITAL_PULSE, ALARM_LOW, 3, 40 << 16, 3 << 16, 3 * CLOCKS_PER_SECOND},
+    {VITAL_PULSE, ALARM_HIGH, 2, 150 << 16, 5 << 16, 3 * CLOCKS_PER_SECOND},
+    {VITAL_PULSE, ALARM_RATE, 1, 40 << 16, 10 << 16, 2 * CLOCKS_PER_SECOND},
+    {VITAL_PULSE, ALARM_LOSS, 1, 5 * CLOCKS_PER_SECOND, 0, 0},
+    {VITAL_BREATH, ALARM_LOW, 3, 5 << 16, 1 << 16, 10 * CLOCKS_PER_SECOND},
+    {VITAL_BREATH, ALARM_HIGH, 2, 20 << 16, 2 << 16, 10 * CLOCKS_PER_SECOND},
+    {VITAL_BREATH, ALARM_RATE, 1, 5 << 16, 1 << 16, 10 * CLOCKS_PER_SECOND},
+    {VITAL_BREATH, ALARM_LOSS, 4, 30 * CLOCKS_PER_SECOND, 0, 0},
+};
+#define NUM_ALARM_RULES (sizeof(alarm_rules) / sizeof(alarm_rules[0]))
+ALARMS alarms;
+
+// alarm limits and strain calibration kept in EEPROM, these are used when
+// it holds no good record: 40 to 150 BPM, 5 to 20 breaths per minute and
+// unity scale until a span is measured
+const CONFIG config_default = {40 << 16, 150 << 16, 5 << 16, 20 << 16,
+                               {0, STRAIN_UNITY}};
+CONFIG_STORE config_store;
+bool eeprom_ok = false;
+
+// set by TIMER2A while a stream is running
+volatile bool stream_due = false;
+uint8_t stream_fields = 0;
+
+// binary front end. A host that sends nothing for RPC_IDLE_SECONDS is
+// taken to be gone and the shell comes back.
+#define RPC_IDLE_SECONDS 30
+RPC_SERVER rpc_server;
+volatile uint32_t strain_samples = 0;
+
+// view of one field in the line buffer, type is 'a' or 'n' (numeric)
+typedef struct _FIELD {
+    uint8_t offset;
+    uint8_t length;
+    char type;
+} FIELD;
 
 typedef struct _USER_DATA {
     char buffer[MAX_CHARS + 1];
-    uint8_t fieldCount;
-    uint8_t fieldPosition[MAX_FIELDS];
-    char fieldType[MAX_FIELDS];
+    uint8_t fieldCount;  // including the command name
+    FIELD field[MAX_FIELDS];
 } USER_DATA;
 
 // initialize data struct
 USER_DATA data;
 
+// shell command, minArguments counts the fields after the name
+typedef struct _COMMAND {
+    const char *name;
+    uint8_t minArguments;
+    void (*handler)(USER_DATA *data);
+    const char *help;
+} COMMAND;
+
 // function headers
-char *getFieldString(USER_DATA *data, uint8_t fieldNumber);
-int32_t getFieldInteger(USER_DATA *data, uint8_t fieldNumber);
+int compareField(const USER_DATA *data, uint8_t fieldNumber, const char *str);
+NUMBER_STATUS getFieldInteger(const USER_DATA *data, uint8_t fieldNumber,
+                              int32_t *value);
+NUMBER_STATUS getFieldFixed(const USER_DATA *data, uint8_t fieldNumber,
+                            int32_t *value);
 void parseFields(USER_DATA *data);
-int str_to_int(char *str);
-bool str_comp(char *data_command, const char strCommand[]);
-bool isCommand(USER_DATA *data, const char strCommand[], uint8_t minArguments);
 uint16_t getsUart0(USER_DATA *data);
+void run_tasks();
+void run_rpc();
 
 // Subroutines
+// The RPC preamble switches to binary frames and returns an empty line
+// once the host sends RPC_EXIT
 uint16_t getsUart0(USER_DATA *data) {
     uint16_t count = 0;
     char c;
     while (count != MAX_CHARS) {
+        while (!kbhitUart0()) {
+            run_tasks();
+        }
         c = getcUart0();
+        if (matchRpcPreamble(&rpc_server, c)) {
+            run_rpc();
+            data->buffer[0] = '\0';
+            return 0;
+        }
         if (count > 0 && (c == 8 | c == 127)) {
             count--;
         } else if (c == 13) {
@@ -119,161 +223,123 @@ uint16_t getsUart0(USER_DATA *data) {
     return 0;
 }
 
-int str_to_int(char *str) {
-    int32_t to_int = 0;
-    uint8_t i = 0;
-    while (str[i] != '\0') {
-        to_int = to_int * 10;
-        to_int += str[i] - 48;
-        i++;
-    }
-    return to_int;
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+
+bool isFieldChar(char c) {
+    return isDigit(c) || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') ||
+           c == '-' || c == '+' || c == '.';
 }
 
+// One pass over the line: every run of letters, digits, signs and points
+// becomes a view, anything else separates fields. The buffer is not
+// modified and the scan stops at the terminator or MAX_CHARS.
 void parseFields(USER_DATA *data) {
+    uint8_t i = 0, start;
+    FIELD *field;
+
     data->fieldCount = 0;
-    uint8_t i = 0;
-    bool first = true;
-
-    while (i <= MAX_CHARS + 1) {
-        if (data->buffer[i] > 47 && data->buffer[i] < 58) {  // 0-9
-            if (first == true) {
-                data->fieldType[data->fieldCount] = 'n';
-                first = false;
-            }
-        } else if ((data->buffer[i] > 65 && data->buffer[i] < 90) |   // A-Z
-                   (data->buffer[i] > 96 && data->buffer[i] < 123) |  // a-z
-                   ((data->buffer[i] == '-') |                        // '-'
-                    (data->buffer[i] == '.'))) {                      // '.'
-            if (first == true) {
-                data->fieldType[data->fieldCount] = 'a';
-                first = false;
-            }
-        } else if ((data->buffer[i] == '\n') | (data->buffer[i] == '\0')) {
-            data->buffer[i] = '\0';
-            break;
-        } else {
-            first = true;
-            data->buffer[i] = '\0';
-            data->fieldPosition[data->fieldCount] = i;
-            data->fieldCount++;
+    while (i < MAX_CHARS && data->buffer[i] != '\0') {
+        if (!isFieldChar(data->buffer[i])) {
+            i++;
+            continue;
+        }
+        start = i;
+        while (i < MAX_CHARS && isFieldChar(data->buffer[i])) {
+            i++;
+        }
+        if (data->fieldCount == MAX_FIELDS) {
+            continue;
+        }
+        field = &data->field[data->fieldCount++];
+        field->offset = start;
+        field->length = i - start;
+        // numeric if it starts with a digit, or a sign or point and a digit
+        field->type = 'a';
+        if (isDigit(data->buffer[start]) ||
+            (field->length > 1 && isDigit(data->buffer[start + 1]) &&
+             (data->buffer[start] == '-' || data->buffer[start] == '+' ||
+              data->buffer[start] == '.'))) {
+            field->type = 'n';
         }
-        i++;
-    }
-}
-
-int32_t getFieldInteger(USER_DATA *data, uint8_t fieldNumber) {
-    char *str = getFieldString(data, fieldNumber);
-
-    if (str == NULL) {
-        return 0;
-    } else {
-        return str_to_int(str);
     }
 }
 
-char *getFieldString(USER_DATA *data, uint8_t fieldNumber) {
-    uint8_t i;
-    for (i = 0; i < MAX_CHARS + 1; i++) {
-        str[i] = 0;
+// strcmp order of a field against str, a missing field sorts first
+int compareField(const USER_DATA *data, uint8_t fieldNumber, const char *str) {
+    const char *view;
+    uint8_t i, length;
+    if (fieldNumber >= data->fieldCount) {
+        return -1;
     }
-
-    if (data->fieldType[fieldNumber] == '\0') {
-        return NULL;
+    view = &data->buffer[data->field[fieldNumber].offset];
+    length = data->field[fieldNumber].length;
+    for (i = 0; i < length; i++) {
+        if (str[i] != view[i]) {
+            // also covers str ending early, since view has no terminator
+            return (uint8_t)view[i] - (uint8_t)str[i];
+        }
     }
+    return str[length] == '\0' ? 0 : -1;
+}
 
-    uint8_t field_index = 0;
-    if (fieldNumber != 0) {
-        field_index = data->fieldPosition[fieldNumber - 1];
-        field_index++;
+// Signed decimal or 0x hex field, value is left alone unless NUMBER_OK
+NUMBER_STATUS getFieldInteger(const USER_DATA *data, uint8_t fieldNumber,
+                              int32_t *value) {
+    if (fieldNumber >= data->fieldCount) {
+        return NUMBER_EMPTY;
     }
-    i = 0;
-    while (data->buffer[field_index] != '\0') {
-        str[i] = data->buffer[field_index];
-        field_index++;
-        i++;
-    }
-
-    return str;
+    return parseInteger(&data->buffer[data->field[fieldNumber].offset],
+                        data->field[fieldNumber].length, value);
 }
 
-bool str_comp(char *data_command, const char strCommand[]) {
-    uint8_t i = 0;
-    while (data_command[i] != '\0') {
-        if (data_command[i] != strCommand[i]) {
-            return false;
-        }
-        i++;
+// Signed decimal field as Q16.16
+NUMBER_STATUS getFieldFixed(const USER_DATA *data, uint8_t fieldNumber,
+                            int32_t *value) {
+    if (fieldNumber >= data->fieldCount) {
+        return NUMBER_EMPTY;
     }
-    return true;
+    return parseFixed(&data->buffer[data->field[fieldNumber].offset],
+                      data->field[fieldNumber].length, value);
 }
 
-bool isCommand(USER_DATA *data, const char strCommand[], uint8_t minArguments) {
-    if (str_comp(getFieldString(data, 0), strCommand)) {
-        if (data->fieldCount >= minArguments) {
-            return true;
-        } else {
-            return false;
-        }
+// Reports a bad argument, returns true if it parsed
+bool check_number(NUMBER_STATUS status) {
+    if (status == NUMBER_OVERFLOW) {
+        putsUart0("Number out of range\n");
+    } else if (status != NUMBER_OK) {
+        putsUart0("Not a number\n");
     }
-    return false;
+    return status == NUMBER_OK;
 }
 
 float calc_bpm(uint32_t time) {
     float micro = time / 40;
     float sec = micro / 1000000;
-    float bpm = sec * 60;
+    float bpm = 60 / sec;
     return bpm;
 }
 
-void disableCounterMode() {
-    TIMER1_CTL_R &= ~TIMER_CTL_TAEN;         // turn-off time base timer
-    WTIMER1_CTL_R &= ~TIMER_CTL_TAEN;        // turn-off event counter
-    NVIC_DIS0_R |= 1 << (INT_TIMER1A - 16);  // turn-off interrupt 37 (TIMER1A)
-}
-
-void enableTimerMode() {
-    WTIMER1_CTL_R &= ~TIMER_CTL_TAEN;  // turn-off counter before reconfiguring
-    WTIMER1_CFG_R = 4;                 // configure as 32-bit counter (A only)
-    WTIMER1_TAMR_R = TIMER_TAMR_TACMR | TIMER_TAMR_TAMR_CAP | TIMER_TAMR_TACDIR;
-    // configure for edge time mode, count up
-    WTIMER1_CTL_R = TIMER_CTL_TAEVENT_POS;  // measure time from positive edge
-                                            // to positive edge
-    WTIMER1_IMR_R = TIMER_IMR_CAEIM;        // turn-on interrupts
-    WTIMER1_TAV_R = 0;                      // zero counter for first period
-    WTIMER1_CTL_R |= TIMER_CTL_TAEN;        // turn-on counter
-    NVIC_EN3_R |=
-        1 << (INT_WTIMER1A - 16 - 96);  // turn-on interrupt 112 (WTIMER1A)
-}
-
-// Period timer service publishing latest time measurements every positive edge
-void wideTimer1Isr() {
-    time = WTIMER1_TAV_R;               // read counter input
-    WTIMER1_TAV_R = 0;                  // zero counter for next edge
-    WTIMER1_ICR_R = TIMER_ICR_CAECINT;  // clear interrupt flag
-}
-
 // Initialize Hardware
 void initHw() {
     // Initialize system clock to 40 MHz
     initSystemClockTo40Mhz();
 
     // Enable clocks
-    SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R1 | SYSCTL_RCGCTIMER_R3 |
-                          SYSCTL_RCGCTIMER_R4 | SYSCTL_RCGCWTIMER_R5;
+    SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R1 | SYSCTL_RCGCTIMER_R2 |
+                          SYSCTL_RCGCTIMER_R3 | SYSCTL_RCGCTIMER_R4 |
+                          SYSCTL_RCGCWTIMER_R5;
     SYSCTL_RCGCWTIMER_R |= SYSCTL_RCGCWTIMER_R1;
     SYSCTL_RCGCGPIO_R |= SYSCTL_RCGCGPIO_R2 | SYSCTL_RCGCGPIO_R3 |
                          SYSCTL_RCGCGPIO_R4 | SYSCTL_RCGCGPIO_R5;
     _delay_cycles(3);
 
+    // Free-running cycle counter, the time base of every module
+    initCycleCounter();
+
     // Configure builtin LED pins
     GPIO_PORTF_DIR_R |= BUILTIN_MASK | BLUE_LED_MASK;
     GPIO_PORTF_DEN_R |= BUILTIN_MASK | BLUE_LED_MASK;
 
-    // Configure LED pins
-    GPIO_PORTC_DIR_R |= RED_LED_MASK;
-    GPIO_PORTC_DEN_R |= RED_LED_MASK;
-
     // Configure SIGNAL_IN for frequency and time measurements
     GPIO_PORTC_PDR_R |= FREQ_IN_MASK;
     GPIO_PORTC_AFSEL_R |=
@@ -287,32 +353,10 @@ void initHw() {
         AIN3_MASK;  // select alternative functions for AN3 (PE0)
     GPIO_PORTE_DEN_R &= ~AIN3_MASK;   // turn off digital operation on pin PE0
     GPIO_PORTE_AMSEL_R |= AIN3_MASK;  // turn on analog operation on pin PE0
-
-    // set data pin input
-    GPIO_PORTE_DIR_R &= ~DATA_MASK;
-    GPIO_PORTE_DEN_R |= DATA_MASK;
-    GPIO_PORTE_PDR_R |= DATA_MASK;
-
-    // set clk pin output
-    GPIO_PORTD_DIR_R |= CLK_MASK;
-    GPIO_PORTD_DEN_R |= CLK_MASK;
-
-    // Timer 4 periodic setup
-    TIMER4_CTL_R &= ~TIMER_CTL_TAEN;         // disable timer
-    TIMER4_CFG_R = TIMER_CFG_32_BIT_TIMER;   // set CFG to 0
-    TIMER4_TAMR_R = TIMER_TAMR_TAMR_PERIOD;  // set to periodic mode
-    TIMER4_TAILR_R = 40000000;               // 1 Hz freq
-    TIMER4_IMR_R = TIMER_IMR_TATOIM;         // enable interrupt
-
-    GPIO_PORTE_IM_R &= ~DATA_MASK;
-    GPIO_PORTE_IS_R &= ~DATA_MASK;
-    GPIO_PORTE_IBE_R &= ~DATA_MASK;
-    GPIO_PORTE_IEV_R |= DATA_MASK;
-    GPIO_PORTE_IM_R |= DATA_MASK;
 }
 
 void insert_bpm_array(float a) {
-    if ((a < bpm_upper && a > bpm_lower) && a != bpm_array[bpm_index - 1]) {
+    if (a < bpm_upper / 65536.0f && a > bpm_lower / 65536.0f) {
         bpm_array[bpm_index] = a;
         if (bpm_index < BPM_NUM - 1) {
             bpm_index++;
@@ -323,147 +367,505 @@ void insert_bpm_array(float a) {
 }
 
 float get_avg() {
-    uint32_t i = 0, sum = 0, num_vals = 0;
+    uint32_t i = 0, num_vals = 0;
+    float sum = 0;
     for (i = 0; i < BPM_NUM; i++) {
         if (bpm_array[i] != 0) {
             sum += bpm_array[i];
             num_vals++;
         }
     }
+    if (num_vals == 0) {
+        return 0;
+    }
     return sum / num_vals;
 }
 
-void pulse_check() {
-    GPIO_PORTC_DATA_R = RED_LED_MASK;
-    uint32_t light_on = readAdc0Ss3();
+// Forget the BPM readings of the last finger
+void clear_bpm_array() {
+    memset(bpm_array, 0, sizeof(bpm_array));
+    bpm_index = 0;
+    bpm_average = 0;
+}
 
-    waitMicrosecond(50);
+// Run the presence detector on each queued averaged LED on/off pair
+void update_presence() {
+    uint16_t light_on, light_off;
+    while (getPpgSample(&light_on, &light_off)) {
+        light_on_last = light_on;
+        light_off_last = light_off;
+        updatePresence(&presence, light_on, light_off);
+        if (pulse_active && !isFingerPresent(&presence)) {
+            clear_bpm_array();
+        }
+        pulse_active = isFingerPresent(&presence);
+    }
+}
 
-    GPIO_PORTC_DATA_R &= ~RED_LED_MASK;
-    uint32_t light_off = readAdc0Ss3();
+// Feed the spectral estimator while a finger is on the sensor
+void update_heart_rate() {
+    int32_t amplitude;
+    while (getPpgAmplitude(&amplitude)) {
+        if (pulse_active) {
+            addHeartRateSample(&heart_rate, amplitude);
+        } else if (heart_rate.count != 0) {
+            initHeartRate(&heart_rate, PPG_AMPLITUDE_HZ);
+        }
+    }
+}
 
-    int difference = light_off - light_on;
-    if (light_on > 1500 && difference > 60) {
-        pulse_active = true;
-        GPIO_PORTC_DATA_R |= RED_LED_MASK;
-    } else {
-        if (pulse_active == true) {
-            finger_missing_count++;
-            if (finger_missing_count > 2) {
-                pulse_active = false;
-                GPIO_PORTC_DATA_R &= ~RED_LED_MASK;
-            }
+// While a finger is present, average each queued capture period into the
+// BPM and give each beat to the alarms, stamped with its edge time, so
+// displaying never measures. Edges without a finger are comparator noise
+// and are dropped.
+void update_pulse() {
+    CAPTURE_BEAT beat;
+    flushCapture();
+    while (getCaptureBeat(&beat)) {
+        if (!pulse_active) {
+            continue;
         }
+        float bpm = calc_bpm(beat.period);
+        TRACE(TRACE_DEBUG, TRACE_PULSE, TRACE_PULSE_BPM, bpm);
+        insert_bpm_array(bpm);
+        bpm_average = get_avg();
+        addAlarmSample(&alarms, VITAL_PULSE, (int32_t)(bpm * 65536.0f),
+                       beat.time);
     }
-    TIMER4_ICR_R = TIMER_ICR_TATOCINT;
 }
 
+// Prints the latest snapshot, nothing is waited for
 void show_bpm() {
-    float bpm = calc_bpm(time);
-    insert_bpm_array(bpm);
     char str[40];
-    snprintf(str, sizeof(str), "Average BPM: %f\n", get_avg());
+    snprintf(str, sizeof(str), "Average BPM: %f\n", bpm_average);
     putsUart0(str);
-    /*
-    GPIO_PORTC_DATA_R = RED_LED_MASK;
-    snprintf(str, sizeof(str), "BPM:\t%f\n", bpm);
-    putsUart0(str);
-    uint16_t raw;
-    raw = readAdc0Ss3();
-    snprintf(str, sizeof(str), "Raw ADC:          %4" PRIu16 "\n", raw);
-    putsUart0(str);
-    snprintf(str, sizeof(str), "BPM:\t%f\n", bpm);
-    putsUart0(str);
-    */
-    waitMicrosecond(500000);
+    if (heart_rate.valid) {
+        snprintf(str, sizeof(str), "Spectral BPM: %f\n", heart_rate.bpm);
+        putsUart0(str);
+    }
 }
 
-void show_pulse() {
-    float avg = get_avg();
-    if ((pulse_active) && (avg > bpm_lower && avg < bpm_upper)) {
-        RED_LED = 0;
+// Finger present and the average inside the alarm limits
+bool pulse_detected() {
+    return pulse_active && bpm_average > bpm_lower / 65536.0f &&
+           bpm_average < bpm_upper / 65536.0f;
+}
+
+void show_pulse(USER_DATA *data) {
+    if (pulse_detected()) {
         show_bpm();
     } else {
-        RED_LED = 1;
         putsUart0("(not detected)\n");
     }
 }
 
-void set_min_max() {
-    bpm_upper = getFieldInteger(&data, 3);
-    bpm_lower = getFieldInteger(&data, 2);
+void show_respiration(USER_DATA *data) {
+    char str[40];
+    snprintf(str, sizeof(str), "Breathing at %f breaths per minute\n",
+             breath_time);
+    putsUart0(str);
+    if (respiration.valid) {
+        snprintf(str, sizeof(str), "Autocorrelation: %.1f (conf %.2f)\n",
+                 respiration.rate, respiration.confidence);
+        putsUart0(str);
+    }
 }
 
-void set_breath_min_max() {
-    breath_upper = getFieldInteger(&data, 3);
-    breath_lower = getFieldInteger(&data, 2);
+// Current load and the slow baseline the breath detector tracks
+void show_strain(USER_DATA *data) {
+    char str[40];
+    int32_t baseline = breath.baselineSum >> breath_config.baselineShift;
+    snprintf(str, sizeof(str), "Load: %f\n",
+             getStrainLoad(&strain, strain_counts) / 65536.0f);
+    putsUart0(str);
+    snprintf(str, sizeof(str), "Baseline: %f\n",
+             getStrainLoad(&strain, baseline) / 65536.0f);
+    putsUart0(str);
+    if (strain.spanRejected) {
+        putsUart0("Last calibrate rejected, load too large for the reading\n");
+    }
 }
 
-void set_up_down() {
-    if (diff > 0) {
-        // putsUart0("inc\n");
-        if (up >= 3) {
-            if (down >= 3) {
-                up = 0;
-                down = 0;
-                char local_str[40];
-                // 10 samples a second, 60 seconds in a minute
-                breath_time = 60 / (num_samples / 10);
-                snprintf(local_str, sizeof(local_str),
-                         "took %f samples, %f bpm\n", num_samples, breath_time);
-                //"breathing at %d breaths per minute\n", num_samples);
-                // putsUart0("breath cycle\n");
-                // putsUart0(local_str);
-                num_samples = 0;
-            }
-        } else {
-            up++;
+void start_tare(USER_DATA *data) { startStrainTare(&strain); }
+
+void start_calibrate(USER_DATA *data) {
+    int32_t load;
+    if (check_number(getFieldFixed(data, 1, &load))) {
+        startStrainSpan(&strain, load);
+    }
+}
+
+void show_trace(USER_DATA *data) { dumpTrace(); }
+
+// Cycles of the fastest run and per input item, one decimal
+void report_bench(const char *name, uint32_t cycles, uint16_t items) {
+    char str[64];
+    uint32_t tenths = (uint64_t)cycles * 10 / items;
+    snprintf(str, sizeof(str), "%-10s %8lu cycles %6lu.%lu per item\n", name,
+             (unsigned long)cycles, (unsigned long)(tenths / 10),
+             (unsigned long)(tenths % 10));
+    putsUart0(str);
+}
+
+void run_bench(USER_DATA *data) { runBenchmarks(report_bench); }
+
+// Bit 0 a pulse alarm is active, bit 1 a breathing alarm
+uint8_t get_alarm_state() {
+    return isVitalAlarmed(&alarms, VITAL_PULSE) |
+           isVitalAlarmed(&alarms, VITAL_BREATH) << 1;
+}
+
+// TIMER2A timeout, one stream line is due
+void stream_isr() {
+    TIMER2_ICR_R = TIMER_ICR_TATOCINT;
+    stream_due = true;
+}
+
+void start_stream_timer(uint32_t hz) {
+    TIMER2_CTL_R &= ~TIMER_CTL_TAEN;  // turn-off timer before reconfiguring
+    TIMER2_CFG_R = TIMER_CFG_32_BIT_TIMER;
+    TIMER2_TAMR_R = TIMER_TAMR_TAMR_PERIOD;
+    TIMER2_TAILR_R = CLOCKS_PER_SECOND / hz - 1;
+    TIMER2_ICR_R = TIMER_ICR_TATOCINT;
+    TIMER2_IMR_R = TIMER_IMR_TATOIM;
+    NVIC_EN0_R |= 1 << (INT_TIMER2A - 16);  // turn-on interrupt 39 (TIMER2A)
+    TIMER2_CTL_R |= TIMER_CTL_TAEN;
+}
+
+void stop_stream_timer() {
+    TIMER2_CTL_R &= ~TIMER_CTL_TAEN;
+    TIMER2_IMR_R = 0;
+    NVIC_DIS0_R = 1 << (INT_TIMER2A - 16);  // turn-off interrupt 39
+    stream_due = false;
+}
+
+// Shared by the stream command and RPC_START_STREAM
+bool start_stream(uint8_t fields, int32_t hz) {
+    if (!checkRpcStream(fields, hz)) {
+        return false;
+    }
+    stream_fields = fields;
+    start_stream_timer(hz);
+    return true;
+}
+
+// One comma separated line with the selected fields
+void send_stream_line(uint8_t fields) {
+    char line[MAX_CHARS];
+    uint8_t n = 0;
+    line[0] = '\0';
+    if (fields & STREAM_PULSE) {
+        n += snprintf(&line[n], sizeof(line) - n, "%.1f,", bpm_average);
+    }
+    if (fields & STREAM_RESPIRATION) {
+        n += snprintf(&line[n], sizeof(line) - n, "%.1f,", breath_time);
+    }
+    if (fields & STREAM_LIGHT) {
+        n += snprintf(&line[n], sizeof(line) - n, "%u,%u,", light_on_last,
+                      light_off_last);
+    }
+    if (fields & STREAM_STRAIN) {
+        n += snprintf(&line[n], sizeof(line) - n, "%ld,",
+                      (long)strain_counts);
+    }
+    if (fields & STREAM_ALARM) {
+        n += snprintf(&line[n], sizeof(line) - n, "%u,", get_alarm_state());
+    }
+    // replace the last comma
+    if (n > 0) {
+        line[n - 1] = '\n';
+    }
+    putsUart0(line);
+}
+
+// stream <fields> <hz>: fields are letters p(ulse) r(espiration) l(ight)
+// s(train) a(larm), lines are paced by TIMER2A until any key is pressed
+void stream(USER_DATA *data) {
+    const char *letters = &data->buffer[data->field[1].offset];
+    uint8_t fields = 0, i;
+    int32_t hz;
+    for (i = 0; i < data->field[1].length; i++) {
+        switch (letters[i]) {
+            case 'p':
+                fields |= STREAM_PULSE;
+                break;
+            case 'r':
+                fields |= STREAM_RESPIRATION;
+                break;
+            case 'l':
+                fields |= STREAM_LIGHT;
+                break;
+            case 's':
+                fields |= STREAM_STRAIN;
+                break;
+            case 'a':
+                fields |= STREAM_ALARM;
+                break;
+            default:
+                putsUart0("Fields are p r l s a\n");
+                return;
+        }
+    }
+    if (!check_number(getFieldInteger(data, 2, &hz))) {
+        return;
+    }
+    if (!start_stream(fields, hz)) {
+        putsUart0("Rate is 1 to 100 Hz\n");
+        return;
+    }
+
+    while (!kbhitUart0()) {
+        run_tasks();
+        if (stream_due) {
+            stream_due = false;
+            send_stream_line(stream_fields);
         }
-    } else if (diff < 0) {
-        // putsUart0("dec\n");
-        down++;
     }
+    getcUart0();
+    stop_stream_timer();
 }
 
-uint32_t get_breath() {
-    num_samples++;
-    char str[40];
-    uint32_t value = 0;
-    while (!DATA)
-        ;
-    value = 0;
-    uint32_t i;
-    for (i = 0; i < 24; i++) {
-        CLK = 1;
-        waitMicrosecond(3);
-        uint32_t reading = DATA;
-        snprintf(str, sizeof(str), "%d\n", reading);
-        // putsUart0(str);
-        value |= reading;
-        value = value << 1;
-        CLK = 0;
-        _delay_cycles(10);
-    }
-    CLK = 1;
-    waitMicrosecond(10);
-    CLK = 0;
-    _delay_cycles(10);
-
-    snprintf(str, sizeof(str), "%d\n", value);
-    // putsUart0(str);
-
-    diff = value - prev_breath;
-    prev_breath = value;
-    set_up_down();
-
-    // GPIO_PORTE_ICR_R = TIMER_ICR_TATOCINT;
-    if (breath_time > breath_lower && breath_time < breath_upper) {
-        BLUE_LED = 0;
+// Q16.16 limits, shared by the alarm command and RPC_SET_ALARM; false and
+// nothing changes unless 0 <= min < max
+bool set_alarm_limits(bool pulse, int32_t min, int32_t max) {
+    if (!checkRpcLimits(min, max)) {
+        return false;
+    }
+    if (pulse) {
+        bpm_lower = min;
+        bpm_upper = max;
+        setAlarmLimit(&alarms, RULE_PULSE_LOW, min);
+        setAlarmLimit(&alarms, RULE_PULSE_HIGH, max);
     } else {
-        BLUE_LED = 1;
+        breath_lower = min;
+        breath_upper = max;
+        setAlarmLimit(&alarms, RULE_BREATH_LOW, min);
+        setAlarmLimit(&alarms, RULE_BREATH_HIGH, max);
     }
-    GPIO_PORTE_ICR_R = DATA_MASK;
-    return value;
+    return true;
+}
+
+// Limits may have decimals, nothing changes unless the vital is known and
+// both limits parse and are in order
+void set_alarm(USER_DATA *data) {
+    int32_t min, max;
+    bool pulse = compareField(data, 1, "pulse") == 0;
+    bool known = pulse || compareField(data, 1, "breath") == 0;
+    if (known && (!check_number(getFieldFixed(data, 2, &min)) ||
+                  !check_number(getFieldFixed(data, 3, &max)))) {
+        return;
+    }
+    if (!known || !set_alarm_limits(pulse, min, max)) {
+        putsUart0("Usage: alarm pulse|breath <min> <max>, 0 <= min < max\n");
+    }
+}
+
+void send_rpc_bytes(const uint8_t *bytes, uint8_t length) {
+    uint8_t i;
+    for (i = 0; i < length; i++) {
+        putcUart0(bytes[i]);
+    }
+}
+
+// Same readings as the pulse and respiration commands
+void get_rpc_readings(RPC_SERVER_READINGS *readings) {
+    readings->pulseValid = pulse_detected();
+    readings->pulse = bpm_average;
+    readings->spectralValid = heart_rate.valid;
+    readings->spectral = heart_rate.bpm;
+    readings->breath = breath_time;
+    readings->autocorrValid = respiration.valid;
+    readings->autocorr = respiration.rate;
+    readings->confidence = respiration.confidence;
+    readings->lightOn = light_on_last;
+    readings->lightOff = light_off_last;
+    readings->strain = strain_counts;
+    readings->alarm = get_alarm_state();
+}
+
+void get_rpc_stats(RPC_SERVER_STATS *stats) {
+    stats->captures = getCaptureCount();
+    stats->samples = strain_samples;
+    stats->overflows = getCaptureOverflows() + getPpgOverflows() +
+                       breath_samples.overflows +
+                       breath_intervals.overflows + getUart0Overflows();
+}
+
+const RPC_SERVER_PORT rpc_port = {
+    send_rpc_bytes,   get_rpc_readings, get_rpc_stats,
+    set_alarm_limits, start_stream,     stop_stream_timer,
+};
+
+// Binary front end, requests are handled in arrival order while streaming
+// and the background tasks keep running
+void run_rpc() {
+    startRpcServer(&rpc_server, DWT_CYCCNT);
+    while (rpc_server.active) {
+        run_tasks();
+        // take everything the UART interrupt queued since the last pass;
+        // bytes after RPC_EXIT are left for the shell
+        while (rpc_server.active && kbhitUart0()) {
+            addRpcServerByte(&rpc_server, getcUart0(), DWT_CYCCNT);
+        }
+        if (stream_due) {
+            stream_due = false;
+            sendRpcSample(&rpc_server);
+        }
+        checkRpcServerIdle(&rpc_server, DWT_CYCCNT);
+    }
+    stop_stream_timer();
+}
+
+// HX711 conversion callback, runs in interrupt context
+void process_breath(uint8_t gauge, HX711_GAIN gain, int32_t value,
+                    uint32_t time) {
+    // the breathing belt is channel A of the first gauge, channel B is not
+    // wired
+    if (gauge != 0 || gain == HX711_B32) {
+        return;
+    }
+    TRACE(TRACE_DEBUG, TRACE_HX711, TRACE_HX711_SAMPLE, value);
+    strain_samples++;
+    int32_t counts;
+    BREATH_INTERVAL cycle;
+    if (updateStrain(&strain, value, &counts)) {
+        // restart settled on the new zero instead of tracking the step
+        initBreath(&breath, &breath_config);
+    }
+    strain_counts = counts;
+    BREATH_EVENT event = updateBreath(&breath, counts, time);
+    if (event != BREATH_NONE) {
+        pushSampleRing(&breath_samples, breath.last);
+    }
+    switch (event) {
+        case BREATH_PEAK:
+            TRACE(TRACE_DEBUG, TRACE_BREATH, TRACE_BREATH_PEAK, breath.peak);
+            break;
+        case BREATH_TROUGH:
+            TRACE(TRACE_DEBUG, TRACE_BREATH, TRACE_BREATH_TROUGH,
+                  breath.trough);
+            break;
+        case BREATH_CYCLE:
+            cycle.interval = breath.interval;
+            cycle.time = time;
+            pushIntervalRing(&breath_intervals, cycle);
+            TRACE(TRACE_INFO, TRACE_BREATH, TRACE_BREATH_CYCLE,
+                  breath.interval);
+            break;
+        default:
+            break;
+    }
+}
+
+// Alarm transition, traced and sent to an RPC host as an event
+void report_alarm(uint8_t rule, bool active, int32_t value, uint32_t time) {
+    TRACE(TRACE_INFO, TRACE_ALARM, TRACE_ALARM_CHANGE, rule | active << 8);
+    sendRpcAlarm(&rpc_server, rule, &alarm_rules[rule], active, value);
+}
+
+// Respiration estimate, breath rate and breath alarms from what the HX711
+// interrupt queued
+void update_breath() {
+    int32_t sample;
+    BREATH_INTERVAL cycle;
+    while (popSampleRing(&breath_samples, &sample)) {
+        addRespirationSample(&respiration, sample);
+    }
+    while (popIntervalRing(&breath_intervals, &cycle)) {
+        breath_time = 60.0f * CLOCKS_PER_SECOND / cycle.interval;
+        addAlarmSample(&alarms, VITAL_BREATH,
+                       (int32_t)(breath_time * 65536.0f), cycle.time);
+    }
+}
+
+// Time out lost signals and show the alarms on the LEDs: the vital with
+// the most urgent alarm blinks at about 2 Hz, another alarmed vital stays on
+void update_alarms() {
+    uint32_t time = DWT_CYCCNT;
+    int8_t top;
+    bool blink = (time >> 23) & 1;
+    checkAlarmLoss(&alarms, time);
+    top = getTopAlarm(&alarms);
+    // an alarmed vital means top is a rule
+    RED_LED = isVitalAlarmed(&alarms, VITAL_PULSE) &&
+              (alarm_rules[top].vital != VITAL_PULSE || blink);
+    BLUE_LED = isVitalAlarmed(&alarms, VITAL_BREATH) &&
+               (alarm_rules[top].vital != VITAL_BREATH || blink);
+}
+
+// Save the settings once they differ from the EEPROM copy, only from the
+// main loop since a write takes milliseconds
+void update_config() {
+    CONFIG config;
+    uint32_t state;
+    if (!eeprom_ok) {
+        return;
+    }
+    config.bpmLower = bpm_lower;
+    config.bpmUpper = bpm_upper;
+    config.breathLower = breath_lower;
+    config.breathUpper = breath_upper;
+    // a tare or span finishes in the HX711 interrupt
+    state = _disable_IRQ();
+    config.strain = strain.cal;
+    _restore_interrupts(state);
+    if (saveConfig(&config_store, &config)) {
+        TRACE(TRACE_INFO, TRACE_CONFIG, TRACE_CONFIG_SAVED,
+              config_store.sequence);
+    }
+}
+
+// Background work done while the shell waits for input
+void run_tasks() {
+    update_presence();
+    update_pulse();
+    update_heart_rate();
+    update_breath();
+    update_alarms();
+    update_config();
+}
+
+void show_help(USER_DATA *data);
+
+// Shell commands, kept sorted by name for the binary search
+const COMMAND commands[] = {
+    {"alarm", 3, set_alarm, "alarm pulse|breath <min> <max>"},
+    {"bench", 0, run_bench, "bench"},
+    {"calibrate", 1, start_calibrate, "calibrate <load> (after tare)"},
+    {"help", 0, show_help, "help"},
+    {"pulse", 0, show_pulse, "pulse"},
+    {"respiration", 0, show_respiration, "respiration"},
+    {"strain", 0, show_strain, "strain"},
+    {"stream", 2, stream, "stream <p|r|l|s|a...> <hz>"},
+    {"tare", 0, start_tare, "tare (belt relaxed)"},
+    {"trace", 0, show_trace, "trace"},
+};
+#define NUM_COMMANDS (sizeof(commands) / sizeof(commands[0]))
+
+void show_help(USER_DATA *data) {
+    uint8_t i;
+    for (i = 0; i < NUM_COMMANDS; i++) {
+        putsUart0(commands[i].help);
+        putsUart0("\n");
+    }
+}
+
+// Exact match on the command name
+const COMMAND *find_command(const USER_DATA *data) {
+    int8_t low = 0, high = NUM_COMMANDS - 1, mid;
+    int order;
+    while (low <= high) {
+        mid = (low + high) / 2;
+        order = compareField(data, 0, commands[mid].name);
+        if (order == 0) {
+            return &commands[mid];
+        } else if (order < 0) {
+            high = mid - 1;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return NULL;
 }
 
 //-----------------------------------------------------------------------------
@@ -474,54 +876,73 @@ int main(void) {
     // Initialize hardware
     initHw();
     initUart0();
+
+    // restore settings before anything uses them, the two trace records
+    // time the restore
+    CONFIG config = config_default;
+    TRACE(TRACE_INFO, TRACE_CONFIG, TRACE_CONFIG_START, 0);
+    eeprom_ok = initEeprom();
+    if (eeprom_ok) {
+        loadConfig(&config_store, &config, &config_default);
+    }
+    TRACE(TRACE_INFO, TRACE_CONFIG, TRACE_CONFIG_RESTORED,
+          config_store.sequence);
+    initAlarms(&alarms, alarm_rules, NUM_ALARM_RULES, CLOCKS_PER_SECOND,
+               report_alarm, DWT_CYCCNT);
+    // limits saved before they were checked fall back to the defaults
+    if (!set_alarm_limits(true, config.bpmLower, config.bpmUpper)) {
+        set_alarm_limits(true, config_default.bpmLower,
+                         config_default.bpmUpper);
+    }
+    if (!set_alarm_limits(false, config.breathLower, config.breathUpper)) {
+        set_alarm_limits(false, config_default.breathLower,
+                         config_default.breathUpper);
+    }
     initAdc0Ss3();
 
     // Use AIN3 input with N=4 hardware sampling
     setAdc0Ss3Mux(3);
     setAdc0Ss3Log2AverageCount(2);
 
-    // set timer
-    enableTimerMode();
+    // capture pulse edges through uDMA
+    initCapture();
 
-    // enable pulse timer
-    NVIC_EN2_R |= 1 << (86 - 16 - 32 * 2);  // turn on interrupt 32 (TIMER1A)
-    TIMER4_CTL_R |= TIMER_CTL_TAEN;         // enable timer
+    // LED excitation with ADC sampling locked to its phases
+    initPresence(&presence, &presence_config);
+    initHeartRate(&heart_rate, PPG_AMPLITUDE_HZ);
+    initPpg();
 
-    // strain guage interrupt
-    NVIC_EN0_R |= 1 << 4;  // turn on interrupt 32 (TIMER1A)
+    // strain gauge conversions through SSI1
+    initStrain(&strain, &config.strain);
+    initBreath(&breath, &breath_config);
+    initRespiration(&respiration);
+    initSampleRing(&breath_samples);
+    initIntervalRing(&breath_intervals);
+    initHx711(process_breath);
+    initRpcServer(&rpc_server, &rpc_port,
+                  RPC_IDLE_SECONDS * (uint32_t)CLOCKS_PER_SECOND);
 
     // set baud rate
     setUart0BaudRate(115200, 40e6);
 
-    char buf_string[MAX_CHARS + 1];
-
-    // enableBreathTimer();
-
-    char newstr[40];
+    const COMMAND *command;
 
     while (true) {
         putsUart0("> ");
         getsUart0(&data);
         parseFields(&data);
-        if (isCommand(&data, "pulse", 0)) {
-            show_pulse();
-        } else if (isCommand(&data, "respiration", 0)) {
-            snprintf(newstr, sizeof(newstr),
-                     "Breathing at %f breaths per minute\n", breath_time);
-            putsUart0(newstr);
-        } else if (isCommand(&data, "alarm", 3)) {
-            if (str_comp(getFieldString(&data, 1), "pulse")) {
-                set_min_max();
-            } else {
-                set_breath_min_max();
-            }
+        if (data.fieldCount == 0) {
+            continue;
+        }
+        command = find_command(&data);
+        if (command == NULL) {
+            putsUart0("Unknown command, try help\n");
+        } else if (data.fieldCount - 1 < command->minArguments) {
+            putsUart0("Usage: ");
+            putsUart0(command->help);
+            putsUart0("\n");
         } else {
-            snprintf(newstr, sizeof(newstr), "'%s'\n",
-                     getFieldString(&data, 0));
-            putsUart0(newstr);
-            snprintf(newstr, sizeof(newstr), "field count: %d\n",
-                     data.fieldCount);
-            putsUart0(newstr);
+            command->handler(&data);
         }
     }
 }
@@ -0,0 +1,66 @@
+// Lock-in Demodulator
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// Samples arrive at twice the LED carrier, one in each LED phase, so the
+// reference is a +/-1 square wave and the multiply is a sign change. Ambient
+// light and mains flicker land away from DC after the multiply and are
+// removed by two cascaded single pole low-pass stages before decimation.
+// Every sample costs two shift-and-add updates, independent of settings.
+// What is left of the carrier after the low-pass is a small ripple that
+// follows the absolute light level, so each output averages the last
+// sample of either phase to cancel it.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lockin.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initLockin(LOCKIN *lockin, uint8_t shift, uint16_t decimation) {
+    lockin->stage1 = 0;
+    lockin->stage2 = 0;
+    lockin->previous = 0;
+    lockin->shift = shift;
+    lockin->decimation = decimation;
+    lockin->count = 0;
+}
+
+// Feed one ADC sample, returns true with a new amplitude every decimation
+// samples. Amplitude is (LED-off - LED-on) in ADC counts with LOCKIN_OUT_Q
+// fraction bits, matching the sign used by the presence detector.
+bool updateLockin(LOCKIN *lockin, uint16_t sample, bool ledOn,
+                  int32_t *amplitude) {
+    int32_t x = (int32_t)sample << LOCKIN_Q;
+    if (ledOn) {
+        x = -x;
+    }
+    lockin->stage1 += (x - lockin->stage1) >> lockin->shift;
+    lockin->stage2 += (lockin->stage1 - lockin->stage2) >> lockin->shift;
+
+    lockin->count++;
+    if (lockin->count < lockin->decimation) {
+        lockin->previous = lockin->stage2;
+        return false;
+    }
+    lockin->count = 0;
+    // the square wave product averages to half the on/off difference, and
+    // the two-sample sum doubles it back
+    *amplitude = (lockin->stage2 + lockin->previous) >>
+                 (LOCKIN_Q - LOCKIN_OUT_Q);
+    return true;
+}
@@ -0,0 +1,40 @@
+// Lock-in Demodulator
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef LOCKIN_H_
+#define LOCKIN_H_
+
+// Fraction bits of the low-pass state and of the output
+#define LOCKIN_Q 16
+#define LOCKIN_OUT_Q 4
+
+typedef struct _LOCKIN {
+    int32_t stage1;       // first low-pass pole, Q16 ADC counts
+    int32_t stage2;       // second low-pass pole, Q16 ADC counts
+    int32_t previous;     // stage2 one sample earlier
+    uint8_t shift;        // pole coefficient is 2^-shift
+    uint16_t decimation;  // input samples per output, even
+    uint16_t count;
+} LOCKIN;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initLockin(LOCKIN *lockin, uint8_t shift, uint16_t decimation);
+bool updateLockin(LOCKIN *lockin, uint16_t sample, bool ledOn,
+                  int32_t *amplitude);
+
+#endif
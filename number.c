@@ -0,0 +1,130 @@
+// Number Parsing Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// Parses a counted run of characters (no terminator needed) in one pass,
+// so shell field views can be passed straight in. Every character is
+// checked and the magnitude is tested against the limit before each digit
+// is added, so nothing wraps silently. *value is only written on success.
+//
+// parseInteger: [+|-]digits or [+|-]0x hex digits, int32_t range
+// parseFixed:   [+|-]digits[.digits] to Q16.16, rounded to nearest
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "number.h"
+
+// Fraction digits past the ninth are checked but dropped, 10^9 still fits
+// 32 bits
+#define NUMBER_FRACTION_SCALE 1000000000
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Value of a digit in base, or -1
+int8_t getDigitValue(char c, uint8_t base) {
+    int8_t digit = -1;
+    if (c >= '0' && c <= '9') {
+        digit = c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+        digit = c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+        digit = c - 'A' + 10;
+    }
+    return digit < base ? digit : -1;
+}
+
+// Skips a sign, returns the index of the first character after it
+uint8_t parseSign(const char *str, uint8_t length, bool *negative) {
+    *negative = false;
+    if (length > 0 && (str[0] == '-' || str[0] == '+')) {
+        *negative = str[0] == '-';
+        return 1;
+    }
+    return 0;
+}
+
+NUMBER_STATUS parseInteger(const char *str, uint8_t length, int32_t *value) {
+    bool negative;
+    uint8_t i = parseSign(str, length, &negative);
+    uint8_t base = 10;
+    uint32_t limit, magnitude = 0;
+    int8_t digit;
+
+    if (length - i > 2 && str[i] == '0' && (str[i + 1] | 0x20) == 'x') {
+        base = 16;
+        i += 2;
+    }
+    if (i == length) {
+        return NUMBER_EMPTY;
+    }
+    limit = negative ? 0x80000000 : 0x7FFFFFFF;
+    for (; i < length; i++) {
+        digit = getDigitValue(str[i], base);
+        if (digit < 0) {
+            return NUMBER_INVALID;
+        }
+        if (magnitude > (limit - digit) / base) {
+            return NUMBER_OVERFLOW;
+        }
+        magnitude = magnitude * base + digit;
+    }
+    *value = negative ? (int32_t)(0 - magnitude) : (int32_t)magnitude;
+    return NUMBER_OK;
+}
+
+NUMBER_STATUS parseFixed(const char *str, uint8_t length, int32_t *value) {
+    bool negative;
+    uint8_t i = parseSign(str, length, &negative);
+    uint32_t whole = 0, fraction = 0, scale = 1, limit, magnitude;
+    bool digits = false, point = false;
+    int8_t digit;
+
+    // whole part may reach 32768 only when negative
+    limit = negative ? 0x8000 : 0x7FFF;
+    for (; i < length; i++) {
+        if (str[i] == '.' && !point) {
+            point = true;
+            continue;
+        }
+        digit = getDigitValue(str[i], 10);
+        if (digit < 0) {
+            return NUMBER_INVALID;
+        }
+        digits = true;
+        if (!point) {
+            whole = whole * 10 + digit;
+            if (whole > limit) {
+                return NUMBER_OVERFLOW;
+            }
+        } else if (scale < NUMBER_FRACTION_SCALE) {
+            fraction = fraction * 10 + digit;
+            scale *= 10;
+        }
+    }
+    if (!digits) {
+        return NUMBER_EMPTY;
+    }
+
+    // rounding can carry into the whole part
+    magnitude = (whole << 16) +
+                (uint32_t)((((uint64_t)fraction << 16) + scale / 2) / scale);
+    if (magnitude > (negative ? 0x80000000 : 0x7FFFFFFF)) {
+        return NUMBER_OVERFLOW;
+    }
+    *value = negative ? (int32_t)(0 - magnitude) : (int32_t)magnitude;
+    return NUMBER_OK;
+}
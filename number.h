@@ -0,0 +1,33 @@
+// Number Parsing Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef NUMBER_H_
+#define NUMBER_H_
+
+typedef enum _NUMBER_STATUS {
+    NUMBER_OK,
+    NUMBER_EMPTY,    // no digits
+    NUMBER_INVALID,  // a character that does not belong
+    NUMBER_OVERFLOW  // does not fit the result
+} NUMBER_STATUS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+NUMBER_STATUS parseInteger(const char *str, uint8_t length, int32_t *value);
+NUMBER_STATUS parseFixed(const char *str, uint8_t length, int32_t *value);
+
+#endif
@@ -0,0 +1,179 @@
+// PPG Excitation Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// LED on PC7 (WT1CCP1), driven by WTIMER1B in PWM mode (split and mode set
+// by initCapture(), which must run first)
+// Phototransistor on AIN3 (PE0), sampled by ADC0 SS3
+// TIMER5A triggers SS3 in the middle of each LED-on and LED-off phase
+
+// The sample stream feeds two consumers: on/off pair averages for finger
+// detection and a lock-in demodulator (lockin.c) for the pulse waveform.
+// PC7 has no PWM module output, so the LED is driven by the other half of
+// the wide timer that captures pulse edges. Both timers run from the system
+// clock, so once started the ADC triggers stay locked to the LED phases:
+//
+//   LED      ____/""""""""\________/""""""""\____
+//   trigger       ^    on      ^  off   ^
+//
+// The first trigger falls in an LED-on phase and they alternate from there,
+// so the phase of each sample follows from the trigger count alone.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "adc0.h"
+#include "lockin.h"
+#include "ppg.h"
+#include "ring.h"
+#include "tm4c123gh6pm.h"
+
+#define PPG_PERIOD (40000000 / PPG_LED_HZ)
+
+// PortC masks
+#define PPG_LED_MASK 128
+
+typedef struct _PPG_PAIR {
+    uint16_t lightOn;
+    uint16_t lightOff;
+} PPG_PAIR;
+
+// Results waiting for the main loop, amplitudes come at 25 Hz so 16 cover
+// a slow spectral estimate
+SPSC_RING(PAIR_RING, PairRing, PPG_PAIR, 4)
+SPSC_RING(AMPLITUDE_RING, AmplitudeRing, int32_t, 16)
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+uint32_t ppg_on_sum = 0;
+uint32_t ppg_off_sum = 0;
+uint16_t ppg_pairs = 0;
+bool ppg_have_on = false;
+bool ppg_next_on = true;  // phase of the next trigger
+
+LOCKIN ppg_lockin;
+AMPLITUDE_RING ppg_amplitudes;
+PAIR_RING ppg_pairs_ready;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initPpg() {
+    initPairRing(&ppg_pairs_ready);
+    initAmplitudeRing(&ppg_amplitudes);
+
+    // Enable clocks
+    SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R5;
+    SYSCTL_RCGCWTIMER_R |= SYSCTL_RCGCWTIMER_R1;
+    SYSCTL_RCGCGPIO_R |= SYSCTL_RCGCGPIO_R2;
+    _delay_cycles(3);
+
+    // Hand PC7 to WT1CCP1
+    GPIO_PORTC_AFSEL_R |= PPG_LED_MASK;
+    GPIO_PORTC_PCTL_R &= ~GPIO_PCTL_PC7_M;
+    GPIO_PORTC_PCTL_R |= GPIO_PCTL_PC7_WT1CCP1;
+    GPIO_PORTC_DEN_R |= PPG_LED_MASK;
+
+    // WTIMER1B PWM: output high from reload until match, so the first half
+    // of every period is LED-on
+    WTIMER1_CTL_R &= ~(TIMER_CTL_TBEN | TIMER_CTL_TBPWML);
+    WTIMER1_TBILR_R = PPG_PERIOD - 1;
+    WTIMER1_TBMATCHR_R = PPG_PERIOD / 2;
+
+    // TIMER5A at twice the LED rate, first timeout a quarter period in
+    TIMER5_CTL_R &= ~TIMER_CTL_TAEN;
+    TIMER5_CFG_R = TIMER_CFG_32_BIT_TIMER;
+    TIMER5_TAMR_R = TIMER_TAMR_TAMR_PERIOD;
+    TIMER5_TAILR_R = PPG_PERIOD / 2 - 1;
+    TIMER5_TAV_R = PPG_PERIOD / 4;
+    TIMER5_IMR_R = 0;
+    TIMER5_CTL_R |= TIMER_CTL_TAOTE;  // timeout triggers the ADC
+
+    initLockin(&ppg_lockin, PPG_LOCKIN_SHIFT, PPG_LOCKIN_DECIMATION);
+    setAdc0Ss3Trigger(ADC_EMUX_EM3_TIMER);
+    enableAdc0Ss3Interrupt();
+
+    // Start back to back so the phase offset is fixed
+    ppg_next_on = true;
+    WTIMER1_CTL_R |= TIMER_CTL_TBEN;
+    TIMER5_CTL_R |= TIMER_CTL_TAEN;
+}
+
+// Collect one mid-phase sample and average complete on/off pairs
+void adc0Ss3Isr() {
+    uint16_t sample = ADC0_SSFIFO3_R;
+    bool led_on = ppg_next_on;
+    int32_t amplitude;
+    PPG_PAIR pair;
+    bool repeat = false;
+    ADC0_ISC_R = ADC_ISC_IN3;
+    ppg_next_on = !led_on;
+    // a conversion dropped on a full FIFO still used up a phase, so the
+    // next sample repeats this one; an on sample waits for it so the pair
+    // does not get two
+    if (ADC0_OSTAT_R & ADC_OSTAT_OV3) {
+        ADC0_OSTAT_R = ADC_OSTAT_OV3;
+        ppg_next_on = led_on;
+        repeat = true;
+    }
+
+    if (updateLockin(&ppg_lockin, sample, led_on, &amplitude)) {
+        pushAmplitudeRing(&ppg_amplitudes, amplitude);
+    }
+
+    if (led_on) {
+        if (!repeat) {
+            ppg_on_sum += sample;
+            ppg_have_on = true;
+        }
+    } else if (ppg_have_on) {
+        ppg_off_sum += sample;
+        ppg_have_on = false;
+        ppg_pairs++;
+        if (ppg_pairs == PPG_PAIRS_PER_SAMPLE) {
+            pair.lightOn = ppg_on_sum / PPG_PAIRS_PER_SAMPLE;
+            pair.lightOff = ppg_off_sum / PPG_PAIRS_PER_SAMPLE;
+            pushPairRing(&ppg_pairs_ready, pair);
+            ppg_on_sum = 0;
+            ppg_off_sum = 0;
+            ppg_pairs = 0;
+        }
+    }
+}
+
+// Takes the oldest averaged sample pair, false if there is none
+bool getPpgSample(uint16_t *lightOn, uint16_t *lightOff) {
+    PPG_PAIR pair;
+    if (!popPairRing(&ppg_pairs_ready, &pair)) {
+        return false;
+    }
+    *lightOn = pair.lightOn;
+    *lightOff = pair.lightOff;
+    return true;
+}
+
+// Takes the oldest demodulated amplitude (LOCKIN_OUT_Q ADC counts), false
+// if there is none
+bool getPpgAmplitude(int32_t *amplitude) {
+    return popAmplitudeRing(&ppg_amplitudes, amplitude);
+}
+
+// Pairs and amplitudes dropped because the main loop fell behind
+uint32_t getPpgOverflows() {
+    return ppg_pairs_ready.overflows + ppg_amplitudes.overflows;
+}
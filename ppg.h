@@ -0,0 +1,42 @@
+// PPG Excitation Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Hardware configuration:
+// LED on PC7 (WT1CCP1), driven by WTIMER1B in PWM mode
+// Phototransistor on AIN3 (PE0), sampled by ADC0 SS3
+// TIMER5A triggers SS3 in the middle of each LED-on and LED-off phase
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef PPG_H_
+#define PPG_H_
+
+#define PPG_LED_HZ 1000
+// LED periods averaged into one on/off sample pair (10 Hz)
+#define PPG_PAIRS_PER_SAMPLE 100
+// Lock-in low-pass pole (2^-shift) and ADC samples per amplitude (25 Hz)
+#define PPG_LOCKIN_SHIFT 5
+#define PPG_LOCKIN_DECIMATION 80
+#define PPG_AMPLITUDE_HZ (2 * PPG_LED_HZ / PPG_LOCKIN_DECIMATION)
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initPpg();
+void adc0Ss3Isr();
+bool getPpgSample(uint16_t *lightOn, uint16_t *lightOff);
+bool getPpgAmplitude(int32_t *amplitude);
+uint32_t getPpgOverflows();
+
+#endif
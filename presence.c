@@ -0,0 +1,99 @@
+// Finger Presence Detector
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// States:
+//   ABSENT    no finger, nothing is measured
+//   ACQUIRING finger seen, waiting for acquireCount hits in a row
+//   PRESENT   finger confirmed
+//   LOST      finger missing, still reported until lostCount misses in a row
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "presence.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initPresence(PRESENCE *presence, const PRESENCE_CONFIG *config) {
+    presence->config = config;
+    presence->state = PRESENCE_ABSENT;
+    presence->count = 0;
+}
+
+// Feed one LED-on/LED-off sample pair, returns the new state
+PRESENCE_STATE updatePresence(PRESENCE *presence, uint16_t lightOn,
+                              uint16_t lightOff) {
+    const PRESENCE_CONFIG *config = presence->config;
+    int32_t difference = (int32_t)lightOff - (int32_t)lightOn;
+    bool lit = lightOn > config->minLight;
+    // a finger must clear the higher threshold to be acquired, but only has
+    // to stay above the lower one to be kept
+    bool enter = lit && difference > config->enterDiff;
+    bool stay = lit && difference > config->exitDiff;
+
+    switch (presence->state) {
+        case PRESENCE_ABSENT:
+            if (enter) {
+                presence->state = PRESENCE_ACQUIRING;
+                presence->count = 0;
+            } else {
+                break;
+            }
+            // fall through - the first hit counts
+        case PRESENCE_ACQUIRING:
+            if (enter) {
+                presence->count++;
+                if (presence->count >= config->acquireCount) {
+                    presence->state = PRESENCE_PRESENT;
+                    presence->count = 0;
+                }
+            } else {
+                presence->state = PRESENCE_ABSENT;
+                presence->count = 0;
+            }
+            break;
+        case PRESENCE_PRESENT:
+            if (!stay) {
+                presence->state = PRESENCE_LOST;
+                presence->count = 1;
+                if (presence->count >= config->lostCount) {
+                    presence->state = PRESENCE_ABSENT;
+                    presence->count = 0;
+                }
+            }
+            break;
+        case PRESENCE_LOST:
+            if (stay) {
+                presence->state = PRESENCE_PRESENT;
+                presence->count = 0;
+            } else {
+                presence->count++;
+                if (presence->count >= config->lostCount) {
+                    presence->state = PRESENCE_ABSENT;
+                    presence->count = 0;
+                }
+            }
+            break;
+    }
+    return presence->state;
+}
+
+// Pulse readings are taken while the finger is confirmed or briefly lost
+bool isFingerPresent(const PRESENCE *presence) {
+    return presence->state == PRESENCE_PRESENT ||
+           presence->state == PRESENCE_LOST;
+}
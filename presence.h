@@ -0,0 +1,50 @@
+// Finger Presence Detector
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef PRESENCE_H_
+#define PRESENCE_H_
+
+typedef enum _PRESENCE_STATE {
+    PRESENCE_ABSENT,
+    PRESENCE_ACQUIRING,
+    PRESENCE_PRESENT,
+    PRESENCE_LOST
+} PRESENCE_STATE;
+
+// Thresholds are in ADC counts, timing is in samples
+typedef struct _PRESENCE_CONFIG {
+    uint16_t minLight;     // LED-on reading needed to trust the comparison
+    int16_t enterDiff;     // off - on difference needed to acquire a finger
+    int16_t exitDiff;      // difference below which a present finger is lost
+    uint8_t acquireCount;  // consecutive hits before ACQUIRING -> PRESENT
+    uint8_t lostCount;     // consecutive misses before LOST -> ABSENT
+} PRESENCE_CONFIG;
+
+typedef struct _PRESENCE {
+    const PRESENCE_CONFIG *config;
+    PRESENCE_STATE state;
+    uint8_t count;
+} PRESENCE;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initPresence(PRESENCE *presence, const PRESENCE_CONFIG *config);
+PRESENCE_STATE updatePresence(PRESENCE *presence, uint16_t lightOn,
+                              uint16_t lightOff);
+bool isFingerPresent(const PRESENCE *presence);
+
+#endif
@@ -0,0 +1,163 @@
+// Autocorrelation Respiration Rate Estimator
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// Keeps, for every lag, the sum of x[n] * x[n - lag] over the last
+// RESP_WINDOW samples. Each new sample adds its products and removes the
+// products of the sample leaving the window, so the cost per sample is two
+// multiply-accumulates per lag whatever the window length. Integer sums are
+// exact, so nothing drifts.
+//
+// Once a second every local maximum is refined with a parabola through its
+// neighbours, and the shortest lag whose peak is within 7/8 of the
+// strongest one is taken as the breath period (this skips the peaks at
+// multiples of the period). Confidence is the correlation there divided by
+// the signal energy; it stays high for regular but shallow breathing, where
+// counting peaks and troughs fails.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "respiration.h"
+
+// Keeps products and window sums well inside 64 bits
+#define RESP_LIMIT (1 << 23)
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initRespiration(RESPIRATION *resp) {
+    uint16_t i;
+    for (i = 0; i < RESP_HISTORY; i++) {
+        resp->history[i] = 0;
+    }
+    for (i = 0; i <= RESP_MAX_LAG + 1; i++) {
+        resp->corr[i] = 0;
+    }
+    for (i = 0; i <= RESP_MAX_LAG; i++) {
+        resp->height[i] = 0;
+        resp->peakLag[i] = 0;
+    }
+    resp->sum = 0;
+    resp->pending = 0;
+    resp->index = 0;
+    resp->count = 0;
+    resp->sinceUpdate = 0;
+    resp->rate = 0;
+    resp->confidence = 0;
+    resp->valid = false;
+}
+
+// Sample lag steps before the newest one
+static inline int32_t getRespHistory(const RESPIRATION *resp, uint16_t lag) {
+    uint16_t i = resp->index + RESP_HISTORY - 1 - lag;
+    if (i >= RESP_HISTORY) {
+        i -= RESP_HISTORY;
+    }
+    return resp->history[i];
+}
+
+// Parabola through a local maximum and its neighbours, gives the refined
+// lag and the correlation at it
+float getRespPeak(const int64_t *r, uint16_t k, float *lag) {
+    float y1 = r[k - 1], y2 = r[k], y3 = r[k + 1];
+    float curve = y1 - 2 * y2 + y3;
+    float delta = 0;
+    if (curve < 0) {
+        delta = 0.5f * (y1 - y3) / curve;
+    }
+    *lag = k + delta;
+    return y2 - 0.25f * (y1 - y3) * delta;
+}
+
+void estimateRespiration(RESPIRATION *resp) {
+    const int64_t *r = resp->corr;
+    float max = 0;
+    uint16_t k;
+
+    resp->valid = false;
+    resp->confidence = 0;
+    if (r[0] <= 0) {
+        return;
+    }
+    for (k = RESP_MIN_LAG; k <= RESP_MAX_LAG; k++) {
+        resp->height[k] = 0;
+        if (r[k] > r[k - 1] && r[k] >= r[k + 1]) {
+            resp->height[k] = getRespPeak(r, k, &resp->peakLag[k]);
+            if (resp->height[k] > max) {
+                max = resp->height[k];
+            }
+        }
+    }
+    if (max <= 0) {
+        return;
+    }
+    for (k = RESP_MIN_LAG; k <= RESP_MAX_LAG; k++) {
+        if (resp->height[k] >= 0.875f * max) {
+            resp->rate = 60.0f * RESP_SAMPLE_HZ / resp->peakLag[k];
+            resp->confidence = resp->height[k] / (float)r[0];
+            if (resp->confidence > 1) {
+                resp->confidence = 1;
+            }
+            resp->valid = true;
+            return;
+        }
+    }
+}
+
+// Feed one breath signal sample, returns true with a new estimate once a
+// second after the window has filled
+bool addRespirationSample(RESPIRATION *resp, int32_t sample) {
+    int32_t x, oldest;
+    uint16_t k;
+
+    resp->sum += sample;
+    resp->pending++;
+    if (resp->pending < RESP_DECIMATION) {
+        return false;
+    }
+    x = resp->sum / RESP_DECIMATION;
+    resp->sum = 0;
+    resp->pending = 0;
+    if (x > RESP_LIMIT) {
+        x = RESP_LIMIT;
+    } else if (x < -RESP_LIMIT) {
+        x = -RESP_LIMIT;
+    }
+
+    resp->history[resp->index] = x;
+    resp->index++;
+    if (resp->index == RESP_HISTORY) {
+        resp->index = 0;
+    }
+    oldest = getRespHistory(resp, RESP_WINDOW);
+    // add the newest sample's products, drop those of the one leaving
+    for (k = 0; k <= RESP_MAX_LAG + 1; k++) {
+        resp->corr[k] +=
+            (int64_t)x * getRespHistory(resp, k) -
+            (int64_t)oldest * getRespHistory(resp, RESP_WINDOW + k);
+    }
+
+    if (resp->count < RESP_WINDOW) {
+        resp->count++;
+    }
+    resp->sinceUpdate++;
+    if (resp->count < RESP_WINDOW || resp->sinceUpdate < RESP_SAMPLE_HZ) {
+        return false;
+    }
+    resp->sinceUpdate = 0;
+    estimateRespiration(resp);
+    return true;
+}
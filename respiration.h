@@ -0,0 +1,51 @@
+// Autocorrelation Respiration Rate Estimator
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef RESPIRATION_H_
+#define RESPIRATION_H_
+
+// Input is the 10 Hz breath signal, averaged in pairs to 5 Hz
+#define RESP_DECIMATION 2
+#define RESP_SAMPLE_HZ 5
+
+// 40 s window, lags for 60 down to 4 breaths per minute
+#define RESP_WINDOW 200
+#define RESP_MIN_LAG 5
+#define RESP_MAX_LAG 75
+#define RESP_HISTORY (RESP_WINDOW + RESP_MAX_LAG + 2)
+
+typedef struct _RESPIRATION {
+    int32_t history[RESP_HISTORY];  // circular, newest at index - 1
+    int64_t corr[RESP_MAX_LAG + 2];  // window sums of x[n] * x[n - lag]
+    float height[RESP_MAX_LAG + 1];  // refined peak of each local maximum
+    float peakLag[RESP_MAX_LAG + 1];  // and the lag it is at
+    int32_t sum;
+    uint8_t pending;
+    uint16_t index;
+    uint16_t count;
+    uint16_t sinceUpdate;
+    float rate;        // breaths per minute
+    float confidence;  // normalized correlation at the chosen lag, 0 to 1
+    bool valid;
+} RESPIRATION;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initRespiration(RESPIRATION *resp);
+bool addRespirationSample(RESPIRATION *resp, int32_t sample);
+
+#endif
@@ -0,0 +1,76 @@
+// Ring Buffer Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// Single producer, single consumer rings for handing data from an
+// interrupt to the main loop without disabling interrupts. The producer
+// only writes head and the consumer only writes tail, both free-running and
+// masked by the power of two size, so neither side ever has to lock the
+// other out. Barriers keep an item visible before the head that publishes
+// it, and read before the tail that gives its slot back. A full ring drops
+// the new item and counts it in overflows.
+//
+// SPSC_RING(TYPE, Stem, ITEM, SIZE) declares the ring type TYPE and the
+// functions initStem(), pushStem() (producer) and popStem() (consumer).
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef RING_H_
+#define RING_H_
+
+#ifdef __TI_COMPILER_VERSION__
+#define RING_BARRIER() __asm(" dmb")
+#else
+#define RING_BARRIER() __sync_synchronize()
+#endif
+
+#define SPSC_RING(TYPE, Stem, ITEM, SIZE)                                  \
+    typedef char Stem##SizeIsPowerOfTwo[((SIZE) & ((SIZE) - 1)) ? -1 : 1]; \
+                                                                           \
+    typedef struct _##TYPE {                                               \
+        volatile uint32_t head;       /* written by the producer */        \
+        volatile uint32_t tail;       /* written by the consumer */        \
+        volatile uint32_t overflows;  /* written by the producer */        \
+        volatile ITEM items[SIZE];                                         \
+    } TYPE;                                                                \
+                                                                           \
+    static inline void init##Stem(TYPE *ring) {                            \
+        ring->head = 0;                                                    \
+        ring->tail = 0;                                                    \
+        ring->overflows = 0;                                               \
+    }                                                                      \
+                                                                           \
+    static inline bool push##Stem(TYPE *ring, ITEM item) {                 \
+        uint32_t head = ring->head;                                        \
+        if (head - ring->tail == (SIZE)) {                                 \
+            ring->overflows++;                                             \
+            return false;                                                  \
+        }                                                                  \
+        ring->items[head & ((SIZE) - 1)] = item;                           \
+        RING_BARRIER();                                                    \
+        ring->head = head + 1;                                             \
+        return true;                                                       \
+    }                                                                      \
+                                                                           \
+    static inline bool pop##Stem(TYPE *ring, ITEM *item) {                 \
+        uint32_t tail = ring->tail;                                        \
+        if (ring->head == tail) {                                          \
+            return false;                                                  \
+        }                                                                  \
+        RING_BARRIER();                                                    \
+        *item = ring->items[tail & ((SIZE) - 1)];                          \
+        RING_BARRIER();                                                    \
+        ring->tail = tail + 1;                                             \
+        return true;                                                       \
+    }
+
+#endif
@@ -0,0 +1,177 @@
+// Binary RPC Framing Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// Frames are built and parsed here without any I/O, so the same code runs
+// on the board and in host tools. The parser takes one byte at a time and
+// resynchronizes on the next SOF after a bad length or CRC, so a reader can
+// feed it whatever arrives without blocking. Requests are independent, so
+// a host may send several before reading the responses and match them by
+// id.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rpc.h"
+
+// Parser states
+#define RPC_WAIT_SOF 0
+#define RPC_WAIT_LENGTH 1
+#define RPC_WAIT_ID 2
+#define RPC_WAIT_OPCODE 3
+#define RPC_WAIT_PAYLOAD 4
+#define RPC_WAIT_CRC 5
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const uint8_t rpcPreamble[RPC_PREAMBLE_LENGTH] = {0xA5, 0x5A, 0xC3, 0x3C};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint8_t updateRpcCrc(uint8_t crc, uint8_t byte) {
+    uint8_t i;
+    crc ^= byte;
+    for (i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+void initRpcParser(RPC_PARSER *parser) {
+    parser->state = RPC_WAIT_SOF;
+    parser->remaining = 0;
+    parser->crc = 0;
+    parser->frames = 0;
+    parser->errors = 0;
+}
+
+// Feed one received byte, returns true when parser->frame holds a complete
+// frame with a good CRC
+bool addRpcByte(RPC_PARSER *parser, uint8_t byte) {
+    RPC_FRAME *frame = &parser->frame;
+    switch (parser->state) {
+        case RPC_WAIT_SOF:
+            if (byte == RPC_SOF) {
+                parser->crc = 0;
+                parser->state = RPC_WAIT_LENGTH;
+            }
+            break;
+        case RPC_WAIT_LENGTH:
+            if (byte < 2 || byte > RPC_MAX_PAYLOAD + 2) {
+                parser->errors++;
+                parser->state = RPC_WAIT_SOF;
+                break;
+            }
+            parser->crc = updateRpcCrc(parser->crc, byte);
+            frame->length = byte - 2;
+            parser->state = RPC_WAIT_ID;
+            break;
+        case RPC_WAIT_ID:
+            parser->crc = updateRpcCrc(parser->crc, byte);
+            frame->id = byte;
+            parser->state = RPC_WAIT_OPCODE;
+            break;
+        case RPC_WAIT_OPCODE:
+            parser->crc = updateRpcCrc(parser->crc, byte);
+            frame->opcode = byte;
+            parser->remaining = frame->length;
+            parser->state =
+                parser->remaining ? RPC_WAIT_PAYLOAD : RPC_WAIT_CRC;
+            break;
+        case RPC_WAIT_PAYLOAD:
+            parser->crc = updateRpcCrc(parser->crc, byte);
+            frame->payload[frame->length - parser->remaining] = byte;
+            parser->remaining--;
+            if (parser->remaining == 0) {
+                parser->state = RPC_WAIT_CRC;
+            }
+            break;
+        case RPC_WAIT_CRC:
+            parser->state = RPC_WAIT_SOF;
+            if (byte != parser->crc) {
+                parser->errors++;
+                return false;
+            }
+            parser->frames++;
+            return true;
+    }
+    return false;
+}
+
+void initRpcFrame(RPC_FRAME *frame, uint8_t id, uint8_t opcode) {
+    frame->id = id;
+    frame->opcode = opcode;
+    frame->length = 0;
+}
+
+// Append a 1, 2 or 4 byte little endian TLV, false if it does not fit
+bool putRpcValue(RPC_FRAME *frame, uint8_t type, int32_t value,
+                 uint8_t length) {
+    uint8_t *p = &frame->payload[frame->length];
+    uint8_t i;
+    if (frame->length + 2 + length > RPC_MAX_PAYLOAD) {
+        return false;
+    }
+    *p++ = type;
+    *p++ = length;
+    for (i = 0; i < length; i++) {
+        *p++ = value >> (8 * i);
+    }
+    frame->length += 2 + length;
+    return true;
+}
+
+// First TLV of type, 1 and 2 byte values are unsigned, 4 byte signed
+bool getRpcValue(const RPC_FRAME *frame, uint8_t type, int32_t *value) {
+    uint8_t i = 0, j, length;
+    uint32_t v;
+    while (i + 2 <= frame->length) {
+        length = frame->payload[i + 1];
+        if (i + 2 + length > frame->length) {
+            return false;
+        }
+        if (frame->payload[i] == type &&
+            (length == 1 || length == 2 || length == 4)) {
+            v = 0;
+            for (j = 0; j < length; j++) {
+                v |= (uint32_t)frame->payload[i + 2 + j] << (8 * j);
+            }
+            *value = (int32_t)v;
+            return true;
+        }
+        i += 2 + length;
+    }
+    return false;
+}
+
+// Serialize a frame, returns the byte count (at most RPC_MAX_FRAME)
+uint8_t encodeRpcFrame(const RPC_FRAME *frame, uint8_t *out) {
+    uint8_t n = 0, i, crc = 0;
+    out[n++] = RPC_SOF;
+    out[n++] = frame->length + 2;
+    out[n++] = frame->id;
+    out[n++] = frame->opcode;
+    for (i = 0; i < frame->length; i++) {
+        out[n++] = frame->payload[i];
+    }
+    for (i = 1; i < n; i++) {
+        crc = updateRpcCrc(crc, out[i]);
+    }
+    out[n++] = crc;
+    return n;
+}
@@ -0,0 +1,105 @@
+// Binary RPC Framing Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef RPC_H_
+#define RPC_H_
+
+// Sent in text mode to switch the UART to frames
+#define RPC_PREAMBLE_LENGTH 4
+extern const uint8_t rpcPreamble[RPC_PREAMBLE_LENGTH];
+
+// Frame: SOF, length, id, opcode, payload, CRC-8
+//   length counts id, opcode and payload
+//   CRC-8 (polynomial 0x07) covers length through the end of the payload
+//   the payload is a list of TLVs: type, length, value (little endian)
+#define RPC_SOF 0xA5
+#define RPC_MAX_PAYLOAD 60
+#define RPC_MAX_FRAME (RPC_MAX_PAYLOAD + 5)
+
+// Opcodes, a response carries the request opcode with RPC_RESPONSE set and
+// the request id. Events are sent unrequested with id 0.
+#define RPC_GET_VITALS 0x01
+#define RPC_SET_ALARM 0x02
+#define RPC_START_STREAM 0x03
+#define RPC_STOP_STREAM 0x04
+#define RPC_GET_STATS 0x05
+#define RPC_EXIT 0x06
+#define RPC_OPCODES 7
+#define RPC_RESPONSE 0x80
+#define RPC_SAMPLE_EVENT 0xC0
+#define RPC_ALARM_EVENT 0xC1
+
+// TLV types, Q16.16 values are 4 byte signed
+#define RPC_STATUS 0x01      // 1 byte RPC_OK, ...
+#define RPC_PULSE 0x10       // Q16.16 average BPM
+#define RPC_SPECTRAL 0x11    // Q16.16 spectral BPM, only when valid
+#define RPC_BREATH 0x12      // Q16.16 breaths per minute
+#define RPC_AUTOCORR 0x13    // Q16.16 breaths per minute, only when valid
+#define RPC_CONFIDENCE 0x14  // Q16.16, 0 to 1
+#define RPC_LIGHT_ON 0x15    // 2 byte ADC counts
+#define RPC_LIGHT_OFF 0x16   // 2 byte ADC counts
+#define RPC_STRAIN 0x17      // 4 byte tared HX711 counts
+#define RPC_ALARM 0x18       // 1 byte alarm bits
+#define RPC_RULE 0x19        // 1 byte alarm rule index
+#define RPC_VITAL 0x1A       // 1 byte, 0 pulse or 1 breath
+#define RPC_KIND 0x1B        // 1 byte, 0 low 1 high 2 rate 3 loss
+#define RPC_PRIORITY 0x1C    // 1 byte, higher is more urgent
+#define RPC_ACTIVE 0x1D      // 1 byte, 1 when the alarm starts
+#define RPC_VALUE 0x1E       // Q16.16 newest reading of the vital
+#define RPC_CHANNEL 0x20     // 1 byte, 0 pulse or 1 breath
+#define RPC_MIN 0x21         // Q16.16
+#define RPC_MAX 0x22         // Q16.16
+#define RPC_FIELDS 0x23      // pulse 1 breath 2 light 4 strain 8 alarm 16
+#define RPC_RATE 0x24        // 1 byte Hz
+#define RPC_CAPTURES 0x30    // 4 byte pulse periods measured
+#define RPC_SAMPLES 0x31     // 4 byte HX711 samples taken
+#define RPC_FRAMES 0x32      // 4 byte good frames received
+#define RPC_ERRORS 0x33      // 4 byte frames dropped (CRC or length)
+#define RPC_OVERFLOWS 0x34   // 4 byte readings dropped by full queues
+
+// Status values
+#define RPC_OK 0
+#define RPC_BAD_OPCODE 1
+#define RPC_BAD_ARGUMENT 2
+
+typedef struct _RPC_FRAME {
+    uint8_t id;
+    uint8_t opcode;
+    uint8_t length;  // payload bytes
+    uint8_t payload[RPC_MAX_PAYLOAD];
+} RPC_FRAME;
+
+typedef struct _RPC_PARSER {
+    RPC_FRAME frame;
+    uint8_t state;
+    uint8_t remaining;
+    uint8_t crc;
+    uint32_t frames;
+    uint32_t errors;
+} RPC_PARSER;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initRpcParser(RPC_PARSER *parser);
+bool addRpcByte(RPC_PARSER *parser, uint8_t byte);
+void initRpcFrame(RPC_FRAME *frame, uint8_t id, uint8_t opcode);
+bool putRpcValue(RPC_FRAME *frame, uint8_t type, int32_t value,
+                 uint8_t length);
+bool getRpcValue(const RPC_FRAME *frame, uint8_t type, int32_t *value);
+uint8_t encodeRpcFrame(const RPC_FRAME *frame, uint8_t *out);
+
+#endif
@@ -0,0 +1,246 @@
+// Binary RPC Server Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// The board's side of the protocol in rpc.h. The text shell hands each byte
+// to matchRpcPreamble() and starts the server once the preamble is seen;
+// from then on bytes go to addRpcServerByte(), which answers each request
+// through a table of handlers indexed by opcode. The server stops on
+// RPC_EXIT or when nothing arrives for idleClocks, and the shell comes
+// back. Readings, limits and the stream timer are reached through a port,
+// so the handlers run unchanged against a simulated board in the host
+// tests. Times are free-running clock counts.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "server.h"
+
+// Handlers fill in response TLVs and return a status
+typedef uint8_t (*RPC_HANDLER)(RPC_SERVER *server, const RPC_FRAME *request,
+                               RPC_FRAME *response);
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initRpcServer(RPC_SERVER *server, const RPC_SERVER_PORT *port,
+                   uint32_t idleClocks) {
+    server->port = port;
+    initRpcParser(&server->parser);
+    server->idleClocks = idleClocks;
+    server->lastByte = 0;
+    server->matched = 0;
+    server->streamFields = 0;
+    server->active = false;
+}
+
+// Q16.16 limits of a vital, shared with the alarm command
+bool checkRpcLimits(int32_t min, int32_t max) {
+    return min >= 0 && min < max;
+}
+
+// Range checked before fields is narrowed to the field bits, shared with
+// the stream command
+bool checkRpcStream(int32_t fields, int32_t hz) {
+    return fields >= 1 && fields <= STREAM_ALL && hz >= 1 &&
+           hz <= STREAM_MAX_HZ;
+}
+
+// Text mode byte, true once it completes the preamble
+bool matchRpcPreamble(RPC_SERVER *server, uint8_t byte) {
+    if (byte == rpcPreamble[server->matched]) {
+        server->matched++;
+        if (server->matched == RPC_PREAMBLE_LENGTH) {
+            server->matched = 0;
+            return true;
+        }
+    } else {
+        server->matched = byte == rpcPreamble[0];
+    }
+    return false;
+}
+
+void startRpcServer(RPC_SERVER *server, uint32_t time) {
+    server->lastByte = time;
+    server->active = true;
+}
+
+void sendRpcFrame(RPC_SERVER *server, const RPC_FRAME *frame) {
+    uint8_t bytes[RPC_MAX_FRAME];
+    server->port->send(bytes, encodeRpcFrame(frame, bytes));
+}
+
+bool putRpcFixed(RPC_FRAME *frame, uint8_t type, float value) {
+    return putRpcValue(frame, type, (int32_t)(value * 65536.0f), 4);
+}
+
+// Same readings as the pulse and respiration commands
+uint8_t getVitals(RPC_SERVER *server, const RPC_FRAME *request,
+                  RPC_FRAME *response) {
+    RPC_SERVER_READINGS readings;
+    (void)request;
+    server->port->getReadings(&readings);
+    if (readings.pulseValid) {
+        putRpcFixed(response, RPC_PULSE, readings.pulse);
+        if (readings.spectralValid) {
+            putRpcFixed(response, RPC_SPECTRAL, readings.spectral);
+        }
+    }
+    putRpcFixed(response, RPC_BREATH, readings.breath);
+    if (readings.autocorrValid) {
+        putRpcFixed(response, RPC_AUTOCORR, readings.autocorr);
+        putRpcFixed(response, RPC_CONFIDENCE, readings.confidence);
+    }
+    putRpcValue(response, RPC_ALARM, readings.alarm, 1);
+    return RPC_OK;
+}
+
+uint8_t setAlarm(RPC_SERVER *server, const RPC_FRAME *request,
+                 RPC_FRAME *response) {
+    int32_t channel, min, max;
+    (void)response;
+    if (!getRpcValue(request, RPC_CHANNEL, &channel) || channel < 0 ||
+        channel > 1 || !getRpcValue(request, RPC_MIN, &min) ||
+        !getRpcValue(request, RPC_MAX, &max) || !checkRpcLimits(min, max) ||
+        !server->port->setLimits(channel == 0, min, max)) {
+        return RPC_BAD_ARGUMENT;
+    }
+    return RPC_OK;
+}
+
+uint8_t startStream(RPC_SERVER *server, const RPC_FRAME *request,
+                    RPC_FRAME *response) {
+    int32_t fields, hz;
+    (void)response;
+    if (!getRpcValue(request, RPC_FIELDS, &fields) ||
+        !getRpcValue(request, RPC_RATE, &hz) || !checkRpcStream(fields, hz) ||
+        !server->port->startStream(fields, hz)) {
+        return RPC_BAD_ARGUMENT;
+    }
+    server->streamFields = fields;
+    return RPC_OK;
+}
+
+uint8_t stopStream(RPC_SERVER *server, const RPC_FRAME *request,
+                   RPC_FRAME *response) {
+    (void)request;
+    (void)response;
+    server->port->stopStream();
+    return RPC_OK;
+}
+
+uint8_t getStats(RPC_SERVER *server, const RPC_FRAME *request,
+                 RPC_FRAME *response) {
+    RPC_SERVER_STATS stats;
+    (void)request;
+    server->port->getStats(&stats);
+    putRpcValue(response, RPC_CAPTURES, stats.captures, 4);
+    putRpcValue(response, RPC_SAMPLES, stats.samples, 4);
+    putRpcValue(response, RPC_FRAMES, server->parser.frames, 4);
+    putRpcValue(response, RPC_ERRORS, server->parser.errors, 4);
+    putRpcValue(response, RPC_OVERFLOWS, stats.overflows, 4);
+    return RPC_OK;
+}
+
+uint8_t exitServer(RPC_SERVER *server, const RPC_FRAME *request,
+                   RPC_FRAME *response) {
+    (void)request;
+    (void)response;
+    server->active = false;
+    return RPC_OK;
+}
+
+const RPC_HANDLER rpcHandlers[RPC_OPCODES] = {
+    NULL,         // 0 unused
+    getVitals,    // RPC_GET_VITALS
+    setAlarm,     // RPC_SET_ALARM
+    startStream,  // RPC_START_STREAM
+    stopStream,   // RPC_STOP_STREAM
+    getStats,     // RPC_GET_STATS
+    exitServer,   // RPC_EXIT
+};
+
+// Answer one request, echoing its id so pipelined requests can be matched
+void handleRpcRequest(RPC_SERVER *server, const RPC_FRAME *request) {
+    RPC_FRAME response;
+    uint8_t status = RPC_BAD_OPCODE;
+    initRpcFrame(&response, request->id, request->opcode | RPC_RESPONSE);
+    if (request->opcode < RPC_OPCODES &&
+        rpcHandlers[request->opcode] != NULL) {
+        status = rpcHandlers[request->opcode](server, request, &response);
+    }
+    if (status != RPC_OK) {
+        response.length = 0;
+    }
+    putRpcValue(&response, RPC_STATUS, status, 1);
+    sendRpcFrame(server, &response);
+}
+
+void addRpcServerByte(RPC_SERVER *server, uint8_t byte, uint32_t time) {
+    server->lastByte = time;
+    if (addRpcByte(&server->parser, byte)) {
+        handleRpcRequest(server, &server->parser.frame);
+    }
+}
+
+// A host that sends nothing for idleClocks is taken to be gone
+void checkRpcServerIdle(RPC_SERVER *server, uint32_t time) {
+    if (time - server->lastByte > server->idleClocks) {
+        server->active = false;
+    }
+}
+
+// Stream sample as an unrequested frame with the streamed readings
+void sendRpcSample(RPC_SERVER *server) {
+    RPC_SERVER_READINGS readings;
+    RPC_FRAME sample;
+    server->port->getReadings(&readings);
+    initRpcFrame(&sample, 0, RPC_SAMPLE_EVENT);
+    if (server->streamFields & STREAM_PULSE) {
+        putRpcFixed(&sample, RPC_PULSE, readings.pulse);
+    }
+    if (server->streamFields & STREAM_RESPIRATION) {
+        putRpcFixed(&sample, RPC_BREATH, readings.breath);
+    }
+    if (server->streamFields & STREAM_LIGHT) {
+        putRpcValue(&sample, RPC_LIGHT_ON, readings.lightOn, 2);
+        putRpcValue(&sample, RPC_LIGHT_OFF, readings.lightOff, 2);
+    }
+    if (server->streamFields & STREAM_STRAIN) {
+        putRpcValue(&sample, RPC_STRAIN, readings.strain, 4);
+    }
+    if (server->streamFields & STREAM_ALARM) {
+        putRpcValue(&sample, RPC_ALARM, readings.alarm, 1);
+    }
+    sendRpcFrame(server, &sample);
+}
+
+// Alarm transition as an unrequested frame, nothing while in text mode
+void sendRpcAlarm(RPC_SERVER *server, uint8_t index, const ALARM_RULE *rule,
+                  bool active, int32_t value) {
+    RPC_FRAME event;
+    if (!server->active) {
+        return;
+    }
+    initRpcFrame(&event, 0, RPC_ALARM_EVENT);
+    putRpcValue(&event, RPC_RULE, index, 1);
+    putRpcValue(&event, RPC_VITAL, rule->vital, 1);
+    putRpcValue(&event, RPC_KIND, rule->kind, 1);
+    putRpcValue(&event, RPC_PRIORITY, rule->priority, 1);
+    putRpcValue(&event, RPC_ACTIVE, active, 1);
+    putRpcValue(&event, RPC_VALUE, value, 4);
+    sendRpcFrame(server, &event);
+}
@@ -0,0 +1,90 @@
+// Binary RPC Server Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include "alarm.h"
+#include "rpc.h"
+
+// Stream fields, also the RPC_FIELDS bits
+#define STREAM_PULSE 1
+#define STREAM_RESPIRATION 2
+#define STREAM_LIGHT 4
+#define STREAM_STRAIN 8
+#define STREAM_ALARM 16
+#define STREAM_ALL 31
+#define STREAM_MAX_HZ 100
+
+// Readings as the shell commands show them
+typedef struct _RPC_SERVER_READINGS {
+    bool pulseValid;  // a finger is on the sensor
+    float pulse;      // BPM, averaged periods
+    bool spectralValid;
+    float spectral;   // BPM, from the spectrum
+    float breath;     // breaths per minute, from the belt cycles
+    bool autocorrValid;
+    float autocorr;   // breaths per minute, from the autocorrelation
+    float confidence;
+    uint16_t lightOn;
+    uint16_t lightOff;
+    int32_t strain;
+    uint8_t alarm;    // bit 0 pulse, bit 1 breath
+} RPC_SERVER_READINGS;
+
+typedef struct _RPC_SERVER_STATS {
+    uint32_t captures;
+    uint32_t samples;
+    uint32_t overflows;
+} RPC_SERVER_STATS;
+
+// What the server needs from the firmware; limits and streams have been
+// checked with checkRpcLimits() and checkRpcStream() before they arrive
+typedef struct _RPC_SERVER_PORT {
+    void (*send)(const uint8_t *bytes, uint8_t length);
+    void (*getReadings)(RPC_SERVER_READINGS *readings);
+    void (*getStats)(RPC_SERVER_STATS *stats);
+    bool (*setLimits)(bool pulse, int32_t min, int32_t max);
+    bool (*startStream)(uint8_t fields, int32_t hz);
+    void (*stopStream)();
+} RPC_SERVER_PORT;
+
+typedef struct _RPC_SERVER {
+    const RPC_SERVER_PORT *port;
+    RPC_PARSER parser;  // counters survive leaving and re-entering
+    uint32_t idleClocks;
+    uint32_t lastByte;
+    uint8_t matched;    // preamble bytes seen in text mode
+    uint8_t streamFields;
+    bool active;
+} RPC_SERVER;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initRpcServer(RPC_SERVER *server, const RPC_SERVER_PORT *port,
+                   uint32_t idleClocks);
+bool checkRpcLimits(int32_t min, int32_t max);
+bool checkRpcStream(int32_t fields, int32_t hz);
+bool matchRpcPreamble(RPC_SERVER *server, uint8_t byte);
+void startRpcServer(RPC_SERVER *server, uint32_t time);
+void addRpcServerByte(RPC_SERVER *server, uint8_t byte, uint32_t time);
+void checkRpcServerIdle(RPC_SERVER *server, uint32_t time);
+void sendRpcSample(RPC_SERVER *server);
+void sendRpcAlarm(RPC_SERVER *server, uint8_t index, const ALARM_RULE *rule,
+                  bool active, int32_t value);
+
+#endif
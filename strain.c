@@ -0,0 +1,118 @@
+// Strain Gauge Calibration
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+// Raw HX711 counts are tared by subtracting the no-load offset. A known
+// load then sets the scale, so counts convert to physical units with one
+// 32 x 32 -> 64 multiply. Tare and span run in the background: the next
+// STRAIN_AVERAGE samples are averaged and updateStrain reports when the new
+// value is in place. updateStrain runs in the HX711 interrupt, so the start
+// functions mask interrupts while they reset the measurement.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "strain.h"
+
+#ifdef __TI_COMPILER_VERSION__
+#define STRAIN_LOCK() uint32_t state = _disable_IRQ()
+#define STRAIN_UNLOCK() _restore_interrupts(state)
+#else
+#define STRAIN_LOCK()
+#define STRAIN_UNLOCK()
+#endif
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initStrain(STRAIN *strain, const STRAIN_CAL *cal) {
+    strain->cal = *cal;
+    strain->spanLoad = 0;
+    strain->sum = 0;
+    strain->count = 0;
+    strain->mode = STRAIN_RUN;
+    strain->spanRejected = false;
+}
+
+// Take the next samples as the no-load reading
+void startStrainTare(STRAIN *strain) {
+    STRAIN_LOCK();
+    strain->sum = 0;
+    strain->count = 0;
+    strain->mode = STRAIN_TARE;
+    STRAIN_UNLOCK();
+}
+
+// Take the next samples as the reading for load (Q16.16), after a tare
+void startStrainSpan(STRAIN *strain, int32_t load) {
+    STRAIN_LOCK();
+    strain->spanLoad = load;
+    strain->sum = 0;
+    strain->count = 0;
+    strain->mode = STRAIN_SPAN;
+    strain->spanRejected = false;
+    STRAIN_UNLOCK();
+}
+
+// Feed one raw sample, counts is the tared value. Returns true when a tare
+// or span has just finished.
+bool updateStrain(STRAIN *strain, int32_t raw, int32_t *counts) {
+    int32_t average;
+    *counts = raw - strain->cal.offset;
+    if (strain->mode == STRAIN_RUN) {
+        return false;
+    }
+
+    // 24-bit samples, so 256 of them still fit the sum
+    strain->sum += raw;
+    strain->count++;
+    if (strain->count < STRAIN_AVERAGE) {
+        return false;
+    }
+    average = strain->sum / STRAIN_AVERAGE;
+    if (strain->mode == STRAIN_TARE) {
+        strain->cal.offset = average;
+    } else {
+        // a load too large for the change in counts (or no change) does
+        // not fit the scale, keep the old one
+        int64_t span = (int64_t)average - strain->cal.offset;
+        int64_t scale = 0;
+        if (span != 0) {
+            scale = (int64_t)strain->spanLoad *
+                    (STRAIN_UNITY >> STRAIN_LOAD_Q) / span;
+        }
+        if (span == 0 || scale > INT32_MAX || scale < INT32_MIN) {
+            strain->spanRejected = true;
+        } else {
+            strain->cal.scale = (int32_t)scale;
+        }
+    }
+    strain->mode = STRAIN_RUN;
+    *counts = raw - strain->cal.offset;
+    return true;
+}
+
+// Tared counts to a Q16.16 load, saturating
+int32_t getStrainLoad(const STRAIN *strain, int32_t counts) {
+    int64_t load = ((int64_t)counts * strain->cal.scale) >>
+                   (STRAIN_SCALE_Q - STRAIN_LOAD_Q);
+    if (load > INT32_MAX) {
+        return INT32_MAX;
+    }
+    if (load < INT32_MIN) {
+        return INT32_MIN;
+    }
+    return load;
+}
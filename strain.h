@@ -0,0 +1,58 @@
+// Strain Gauge Calibration
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (no peripheral access, runs on host or target)
+// System Clock:    -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef STRAIN_H_
+#define STRAIN_H_
+
+// Samples averaged by a tare or span measurement
+#define STRAIN_AVERAGE 16
+
+// Loads are Q16.16 in the unit the span load was given in, the scale is
+// Q8.24 so a fraction of a count per unit still has resolution
+#define STRAIN_LOAD_Q 16
+#define STRAIN_SCALE_Q 24
+#define STRAIN_UNITY (1 << STRAIN_SCALE_Q)
+
+typedef struct _STRAIN_CAL {
+    int32_t offset;  // raw counts with no load
+    int32_t scale;   // Q8.24 load units per count
+} STRAIN_CAL;
+
+typedef enum _STRAIN_MODE {
+    STRAIN_RUN,
+    STRAIN_TARE,  // averaging to set the offset
+    STRAIN_SPAN   // averaging with a known load on to set the scale
+} STRAIN_MODE;
+
+typedef struct _STRAIN {
+    STRAIN_CAL cal;
+    int32_t spanLoad;  // Q16.16
+    int32_t sum;
+    uint8_t count;
+    STRAIN_MODE mode;
+    bool spanRejected;  // last span gave a scale outside Q8.24, kept old
+} STRAIN;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initStrain(STRAIN *strain, const STRAIN_CAL *cal);
+void startStrainTare(STRAIN *strain);
+void startStrainSpan(STRAIN *strain, int32_t load);
+bool updateStrain(STRAIN *strain, int32_t raw, int32_t *counts);
+int32_t getStrainLoad(const STRAIN *strain, int32_t counts);
+
+#endif
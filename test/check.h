@@ -0,0 +1,37 @@
+// Test Check Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// CHECK(cond, format, ...) prints FAIL and the message when cond is false
+// and counts it in failures, which each test defines. A test prints PASSED
+// or FAILED at the end and exits with failures != 0.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef CHECK_H_
+#define CHECK_H_
+
+#include <stdio.h>
+
+extern int failures;
+
+#define CHECK(cond, ...)         \
+    do {                         \
+        if (!(cond)) {           \
+            printf("FAIL: ");    \
+            printf(__VA_ARGS__); \
+            printf("\n");        \
+            failures++;          \
+        }                        \
+    } while (0)
+
+#endif
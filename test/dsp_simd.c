@@ -0,0 +1,68 @@
+// DSP Library, Cortex-M4 Intrinsic Build
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Compiles dsp.c down its DSP_SIMD path on the host. The TI compiler
+// intrinsics are emulated here from the instruction definitions in the
+// ARMv7-M Architecture Reference Manual, independently of the portable
+// helpers in dsp.c, and every kernel is renamed with a simd prefix so it
+// can be linked next to the portable build for test_dsp.c.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+
+#define DSP_SIMD 1
+#define __TI_TMS470_V7M4__ 1
+
+#define initBiquadQ15 simdInitBiquadQ15
+#define runBiquadQ15 simdRunBiquadQ15
+#define initBiquadQ31 simdInitBiquadQ31
+#define runBiquadQ31 simdRunBiquadQ31
+#define initFirQ15 simdInitFirQ15
+#define runFirQ15 simdRunFirQ15
+#define initMovingAverageQ15 simdInitMovingAverageQ15
+#define runMovingAverageQ15 simdRunMovingAverageQ15
+#define initDcBlockerQ15 simdInitDcBlockerQ15
+#define runDcBlockerQ15 simdRunDcBlockerQ15
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// SMLALD: product1 = Rn[15:0] * Rm[15:0], product2 = Rn[31:16] * Rm[31:16],
+// result = RdHi:RdLo + product1 + product2, modulo 2^64
+static inline long long _smlald(long long acc, unsigned a, unsigned b) {
+    int32_t p1 = (int32_t)(int16_t)(a & 0xFFFF) * (int16_t)(b & 0xFFFF);
+    int32_t p2 = (int32_t)(int16_t)(a >> 16) * (int16_t)(b >> 16);
+    return (long long)((uint64_t)acc + (uint64_t)(int64_t)p1 +
+                       (uint64_t)(int64_t)p2);
+}
+
+// SMLALDX: as SMLALD with the halves of Rm swapped
+static inline long long _smlaldx(long long acc, unsigned a, unsigned b) {
+    return _smlald(acc, a, (b << 16) | (b >> 16));
+}
+
+// SSAT Rd, #bits, Rn, ASR #shift: arithmetic shift right, then saturate to
+// a signed bits wide value (the TI compiler's _ssatl is the LSL form)
+static inline int _ssata(int x, int shift, int bits) {
+    int64_t value = (int64_t)x >> shift;
+    int64_t max = ((int64_t)1 << (bits - 1)) - 1;
+    int64_t min = -((int64_t)1 << (bits - 1));
+    return value > max ? (int)max : value < min ? (int)min : (int)value;
+}
+
+// For test_dsp.c to check the emulation itself
+int simdSsata(int x, int shift, int bits) { return _ssata(x, shift, bits); }
+
+#include "../dsp.c"
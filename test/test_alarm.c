@@ -0,0 +1,176 @@
+// Alarm Engine Library Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Runs the alarm rules of the main file at the 40 MHz clock of the board.
+// Checks that readings near a limit trip and clear only once, that a
+// lost vital stays lost until its next sample over gaps many times the
+// range of the 32-bit clock, that the rate rule starts over after such a
+// gap, and that limits at the ends of the Q16.16 range do not overflow.
+//
+//   cc -I.. -o test_alarm test_alarm.c ../alarm.c && ./test_alarm
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "alarm.h"
+#include "check.h"
+
+#define CLOCKS_PER_SECOND 40000000u
+#define TICK (CLOCKS_PER_SECOND / 4)  // main loop loss check period
+
+#define PULSE_LOW 0
+#define PULSE_HIGH 1
+#define PULSE_RATE 2
+#define PULSE_LOSS 3
+#define RULES 4
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const ALARM_RULE rules[RULES] = {
+    {0, ALARM_LOW, 3, 40 << 16, 3 << 16, 3 * CLOCKS_PER_SECOND},
+    {0, ALARM_HIGH, 2, 150 << 16, 5 << 16, 3 * CLOCKS_PER_SECOND},
+    {0, ALARM_RATE, 1, 40 << 16, 10 << 16, 2 * CLOCKS_PER_SECOND},
+    {0, ALARM_LOSS, 1, 5 * CLOCKS_PER_SECOND, 0, 0},
+};
+
+uint16_t turnedOn[RULES], turnedOff[RULES];
+uint32_t now;
+int failures = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void count_change(uint8_t rule, bool active, int32_t value, uint32_t time) {
+    (void)value;
+    (void)time;
+    if (active) {
+        turnedOn[rule]++;
+    } else {
+        turnedOff[rule]++;
+    }
+}
+
+void start(ALARMS *alarms, uint32_t time) {
+    uint8_t i;
+    for (i = 0; i < RULES; i++) {
+        turnedOn[i] = turnedOff[i] = 0;
+    }
+    now = time;
+    initAlarms(alarms, rules, RULES, CLOCKS_PER_SECOND, count_change, now);
+}
+
+// Beats at the given BPM for a number of seconds, with the loss check of
+// the main loop in between
+void beat(ALARMS *alarms, float bpm, uint16_t seconds) {
+    uint32_t period = CLOCKS_PER_SECOND * 60.0f / bpm;
+    uint32_t end = now + seconds * CLOCKS_PER_SECOND;
+    uint32_t next = now;
+    while ((int32_t)(end - now) > 0) {
+        if ((int32_t)(now - next) >= 0) {
+            addAlarmSample(alarms, 0, (int32_t)(bpm * 65536), now);
+            next += period;
+        }
+        checkAlarmLoss(alarms, now);
+        now += TICK;
+    }
+}
+
+void silence(ALARMS *alarms, uint32_t seconds) {
+    uint32_t i;
+    for (i = 0; i < seconds * (CLOCKS_PER_SECOND / TICK); i++) {
+        checkAlarmLoss(alarms, now);
+        now += TICK;
+    }
+}
+
+// Readings alternating around the high limit neither trip the rule nor
+// clear it once it has tripped
+void test_hysteresis() {
+    ALARMS alarms;
+    uint32_t i;
+    start(&alarms, 0);
+    beat(&alarms, 70, 10);
+    CHECK(!isVitalAlarmed(&alarms, 0), "alarm at 70 BPM");
+    for (i = 0; i < 40; i++) {
+        beat(&alarms, i & 1 ? 152 : 148, 1);
+    }
+    CHECK(turnedOn[PULSE_HIGH] == 0, "high limit tripped by single beats");
+    beat(&alarms, 152, 5);
+    for (i = 0; i < 40; i++) {
+        beat(&alarms, i & 1 ? 152 : 148, 1);
+    }
+    CHECK(turnedOn[PULSE_HIGH] == 1 && turnedOff[PULSE_HIGH] == 0,
+          "high limit changed %u/%u times at 152 and near the limit",
+          turnedOn[PULSE_HIGH], turnedOff[PULSE_HIGH]);
+    beat(&alarms, 140, 10);
+    CHECK(turnedOff[PULSE_HIGH] == 1, "high limit did not clear at 140");
+    beat(&alarms, 70, 10);
+    CHECK(!isVitalAlarmed(&alarms, 0), "alarm left at 70 BPM");
+}
+
+// A silent vital stays lost until its next sample, at any start time and
+// for gaps past the wrap of the clock, and the pulse that comes back at a
+// new rate is not compared with the one from before the gap
+void test_loss(uint32_t time, uint32_t seconds) {
+    ALARMS alarms;
+    start(&alarms, time);
+    beat(&alarms, 70, 10);
+    silence(&alarms, seconds);
+    CHECK(turnedOn[PULSE_LOSS] == 1 && turnedOff[PULSE_LOSS] == 0,
+          "loss from %lu changed %u/%u times in %lu s", (unsigned long)time,
+          turnedOn[PULSE_LOSS], turnedOff[PULSE_LOSS],
+          (unsigned long)seconds);
+    CHECK(getTopAlarm(&alarms) == PULSE_LOSS, "loss not the top alarm");
+    beat(&alarms, 120, 10);
+    CHECK(turnedOff[PULSE_LOSS] == 1 && !isVitalAlarmed(&alarms, 0),
+          "loss from %lu not cleared by a new pulse", (unsigned long)time);
+    CHECK(turnedOn[PULSE_RATE] == 0,
+          "rate alarm across a %lu s gap", (unsigned long)seconds);
+}
+
+// Limits at the ends of the Q16.16 range trip once and stay on, the
+// hysteresis must not wrap the clear point round
+void test_extreme_limits() {
+    ALARMS alarms;
+    start(&alarms, 0);
+    setAlarmLimit(&alarms, PULSE_LOW, INT32_MAX);
+    setAlarmLimit(&alarms, PULSE_HIGH, 150 << 16);
+    beat(&alarms, 70, 30);
+    CHECK(turnedOn[PULSE_LOW] == 1 && turnedOff[PULSE_LOW] == 0,
+          "low limit at the top changed %u/%u times", turnedOn[PULSE_LOW],
+          turnedOff[PULSE_LOW]);
+    start(&alarms, 0);
+    setAlarmLimit(&alarms, PULSE_LOW, 0);
+    setAlarmLimit(&alarms, PULSE_HIGH, INT32_MIN + 1);
+    beat(&alarms, 70, 30);
+    CHECK(turnedOn[PULSE_HIGH] == 1 && turnedOff[PULSE_HIGH] == 0,
+          "high limit at the bottom changed %u/%u times",
+          turnedOn[PULSE_HIGH], turnedOff[PULSE_HIGH]);
+}
+
+int main(void) {
+    test_hysteresis();
+    test_extreme_limits();
+    test_loss(0, 20);
+    test_loss(0, 500);
+    test_loss(0xFFFFFFFF - 30 * CLOCKS_PER_SECOND, 1000);
+    test_loss(0x80000000, 3600);
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
@@ -0,0 +1,128 @@
+// Bit Manipulation Library Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Checks transposeBits8x8 against a bit by bit transpose on every single
+// bit matrix and on random matrices, checks that transposing twice gives
+// the input back, and times both versions.
+//
+//   cc -I.. -o test_bits test_bits.c ../bits.c && ./test_bits
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bits.h"
+#include "check.h"
+
+#define TRIALS 1000000
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+int failures = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Bit (row r, column c) is bit 7 - c of in[r]; it moves to row c, column r
+void naive_transpose(const uint8_t *in, uint8_t *out) {
+    uint8_t r, c;
+    memset(out, 0, 8);
+    for (r = 0; r < 8; r++) {
+        for (c = 0; c < 8; c++) {
+            if (in[r] & (0x80 >> c)) {
+                out[c] |= 0x80 >> r;
+            }
+        }
+    }
+}
+
+bool check_matrix(const uint8_t *in) {
+    uint8_t fast[8], slow[8], back[8];
+    transposeBits8x8(in, fast);
+    naive_transpose(in, slow);
+    transposeBits8x8(fast, back);
+    if (memcmp(fast, slow, 8) != 0 || memcmp(back, in, 8) != 0) {
+        CHECK(false, "%02x %02x %02x %02x %02x %02x %02x %02x", in[0],
+              in[1], in[2], in[3], in[4], in[5], in[6], in[7]);
+        return false;
+    }
+    return true;
+}
+
+void test_single_bits() {
+    uint8_t in[8];
+    uint8_t bit;
+    for (bit = 0; bit < 64; bit++) {
+        memset(in, 0, 8);
+        in[bit / 8] = 0x80 >> (bit % 8);
+        check_matrix(in);
+    }
+}
+
+void test_random() {
+    uint8_t in[8];
+    uint32_t trial;
+    uint8_t i;
+    for (trial = 0; trial < TRIALS; trial++) {
+        for (i = 0; i < 8; i++) {
+            in[i] = rand() >> 4;
+        }
+        if (!check_matrix(in)) {
+            return;
+        }
+    }
+}
+
+// Host cost; the target cycle count is in the bench command
+void time_transpose() {
+    uint8_t lines[24], columns[8];
+    uint32_t i, sum = 0, runs = 10000000;
+    double fast, slow;
+    clock_t start;
+    for (i = 0; i < 24; i++) {
+        lines[i] = rand();
+    }
+    start = clock();
+    for (i = 0; i < runs; i++) {
+        lines[i % 24] ^= i;
+        transposeBits8x8(&lines[(i % 3) * 8], columns);
+        sum += columns[i & 7];
+    }
+    fast = (clock() - start) * 1e9 / CLOCKS_PER_SEC / runs;
+    start = clock();
+    for (i = 0; i < runs; i++) {
+        lines[i % 24] ^= i;
+        naive_transpose(&lines[(i % 3) * 8], columns);
+        sum += columns[i & 7];
+    }
+    slow = (clock() - start) * 1e9 / CLOCKS_PER_SEC / runs;
+    printf("transposeBits8x8: %.1f ns, bit by bit %.1f ns (%lu)\n", fast,
+           slow, (unsigned long)sum);
+}
+
+int main(void) {
+    srand(1);
+    test_single_bits();
+    test_random();
+    time_transpose();
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
@@ -0,0 +1,118 @@
+// Breath Detector Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Feeds the detector synthetic strain gauge readings with known breathing
+// rates at both HX711 rates (10 and 80 SPS) with the firmware settings.
+// The readings carry a large offset, a slow drift and noise, the HX711
+// clock runs a few percent off nominal, and the cycle counter time stamps
+// wrap during the run. Every reported breath period and their mean are
+// checked against the true rate.
+//
+//   cc -I.. -o test_breath test_breath.c ../breath.c ../dsp.c -lm
+//   ./test_breath
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "breath.h"
+#include "check.h"
+#include "dsp.h"
+
+#define PI 3.14159265358979
+#define CLOCKS_PER_SECOND 40000000
+#define BREATH_SAMPLE_HZ 10
+#define SECONDS 180
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+int failures = 0;
+
+// Same filter and limits as breath_config in the main file
+const q31_t breath_low_pass[BIQUAD_COEFFS] = {140774468, 281548936, 140774468,
+                                              802932516, -292288564};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+double noise() { return (rand() / (double)RAND_MAX - 0.5) * 2.0; }
+
+// Chest expansion: mostly the breathing fundamental with a sharper inhale
+double strain_reading(double bpm, double t) {
+    double phase = 2 * PI * bpm / 60.0 * t;
+    return 300000.0 + 40.0 * t + 20000.0 * sin(phase) +
+           4000.0 * sin(2 * phase + 0.7) + 1000.0 * noise();
+}
+
+void test_rate(double bpm, uint16_t sps, double clockError) {
+    BREATH_CONFIG config = {breath_low_pass,
+                            sps / BREATH_SAMPLE_HZ,
+                            6,
+                            500,
+                            CLOCKS_PER_SECOND,
+                            30 * CLOCKS_PER_SECOND};
+    BREATH breath;
+    double actualSps = sps * (1 + clockError);
+    // wraps about 60 s in
+    uint32_t start = UINT32_MAX - 60u * CLOCKS_PER_SECOND;
+    uint32_t n, cycles = 0;
+    double sum = 0, worst = 0;
+    initBreath(&breath, &config);
+    for (n = 0; n < SECONDS * actualSps; n++) {
+        double t = n / actualSps;
+        uint32_t time = start + (uint32_t)llround(t * CLOCKS_PER_SECOND);
+        int32_t reading = (int32_t)lround(strain_reading(bpm, t));
+        if (updateBreath(&breath, reading, time) == BREATH_CYCLE) {
+            double rate = 60.0 * CLOCKS_PER_SECOND / breath.interval;
+            double error = fabs(rate - bpm) / bpm;
+            cycles++;
+            sum += rate;
+            if (error > worst) {
+                worst = error;
+            }
+        }
+    }
+    printf("%4.1f BPM at %2u SPS (clock %+.0f%%): %2u breaths, mean %.2f, "
+           "worst %.1f%%\n",
+           bpm, sps, clockError * 100, cycles, cycles ? sum / cycles : 0,
+           worst * 100);
+    // the first couple of breaths go to settling the filter and baseline,
+    // and no breath may be split in two
+    CHECK(cycles + 3 >= SECONDS * bpm / 60 && cycles <= SECONDS * bpm / 60,
+          "%.1f BPM at %u SPS: %u breaths", bpm, sps, cycles);
+    CHECK(cycles != 0 && fabs(sum / cycles - bpm) < 0.01 * bpm,
+          "%.1f BPM at %u SPS: mean %.2f", bpm, sps, sum / cycles);
+    CHECK(worst < 0.05, "%.1f BPM at %u SPS: a breath off by %.1f%%", bpm,
+          sps, worst * 100);
+}
+
+int main(void) {
+    static const double rates[] = {4, 6, 10, 12.5, 15, 20, 30, 40};
+    static const uint16_t sps[] = {10, 80};
+    uint8_t r, s;
+    srand(1);
+    for (s = 0; s < 2; s++) {
+        for (r = 0; r < sizeof(rates) / sizeof(rates[0]); r++) {
+            test_rate(rates[r], sps[s], r & 1 ? 0.05 : -0.05);
+        }
+    }
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
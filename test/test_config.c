@@ -0,0 +1,258 @@
+// Settings Store Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Runs config.c against a RAM copy of the EEPROM. The mock write can stop
+// after any number of words, like a reset in the middle of a write, or
+// fail outright. Checks that records alternate between the two slots with
+// rising sequence numbers, that a torn or corrupted record is rejected by
+// its CRC and the older slot is restored, that a record of another version
+// is ignored, and that sequence numbers compare across their wrap.
+//
+//   cc -I.. -o test_config test_config.c ../config.c && ./test_config
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "check.h"
+#include "config.h"
+#include "eeprom.h"
+
+// Header, sequence, CONFIG and CRC, as laid out by config.c
+#define RECORD_WORDS (sizeof(CONFIG) / 4 + 3)
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+int failures = 0;
+
+uint32_t eeprom[EEPROM_WORDS];
+uint32_t eeprom_writes = 0;
+int16_t eeprom_cut = -1;  // words written before a simulated reset
+bool eeprom_fail = false;
+
+const CONFIG defaults = {40 << 16, 150 << 16, 5 << 16, 20 << 16,
+                         {0, STRAIN_UNITY}};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint32_t getConfigCrc(const uint32_t *words, uint8_t count);
+
+bool initEeprom() { return true; }
+
+void readEeprom(uint16_t address, uint32_t *data, uint8_t count) {
+    memcpy(data, &eeprom[address], count * sizeof(uint32_t));
+}
+
+bool writeEeprom(uint16_t address, const uint32_t *data, uint8_t count) {
+    uint8_t i;
+    if (eeprom_fail) {
+        return false;
+    }
+    eeprom_writes++;
+    for (i = 0; i < count; i++) {
+        if (eeprom_cut >= 0 && i >= eeprom_cut) {
+            return true;
+        }
+        eeprom[address + i] = data[i];
+    }
+    return true;
+}
+
+void erase_eeprom() { memset(eeprom, 0xFF, sizeof(eeprom)); }
+
+// Distinct settings for each step n
+CONFIG make_config(int32_t n) {
+    CONFIG config = defaults;
+    config.bpmLower = (40 + n) << 16;
+    config.breathUpper = ((20 + n) << 16) | 0x8000;
+    config.strain.offset = -1000 * n;
+    config.strain.scale = STRAIN_UNITY + n;
+    return config;
+}
+
+bool same_config(const CONFIG *a, const CONFIG *b) {
+    return memcmp(a, b, sizeof(CONFIG)) == 0;
+}
+
+void test_blank() {
+    CONFIG_STORE store;
+    CONFIG config;
+    erase_eeprom();
+    CHECK(!loadConfig(&store, &config, &defaults), "blank EEPROM restored");
+    CHECK(same_config(&config, &defaults), "blank EEPROM not the defaults");
+    CHECK(store.sequence == 0, "blank sequence %u", store.sequence);
+}
+
+// Changes go to alternating slots with rising sequence numbers, unchanged
+// settings are not written, and a fresh load finds the newest
+void test_alternation() {
+    CONFIG_STORE store, loaded;
+    CONFIG config, restored;
+    int32_t n;
+    erase_eeprom();
+    loadConfig(&store, &config, &defaults);
+    eeprom_writes = 0;
+    CHECK(!saveConfig(&store, &config), "unchanged settings written");
+    CHECK(eeprom_writes == 0, "unchanged settings reached the EEPROM");
+    for (n = 1; n <= 6; n++) {
+        config = make_config(n);
+        CHECK(saveConfig(&store, &config), "save %ld failed", (long)n);
+        CHECK(store.slot == (n - 1) % CONFIG_SLOTS, "save %ld in slot %u",
+              (long)n, store.slot);
+        CHECK(store.sequence == (uint32_t)n, "save %ld sequence %u", (long)n,
+              store.sequence);
+        CHECK(!saveConfig(&store, &config), "save %ld written twice",
+              (long)n);
+        CHECK(loadConfig(&loaded, &restored, &defaults) &&
+                  same_config(&restored, &config) &&
+                  loaded.sequence == store.sequence &&
+                  loaded.slot == store.slot,
+              "save %ld not restored", (long)n);
+    }
+}
+
+// A reset after any number of words of a write leaves the previous record
+void test_torn_write() {
+    CONFIG_STORE store, loaded;
+    CONFIG older, newer, restored;
+    int16_t cut;
+    for (cut = 0; cut < (int16_t)RECORD_WORDS; cut++) {
+        erase_eeprom();
+        loadConfig(&store, &restored, &defaults);
+        // fill both slots so the torn write lands on an old good record
+        older = make_config(1);
+        saveConfig(&store, &older);
+        older = make_config(2);
+        saveConfig(&store, &older);
+        newer = make_config(3);
+        eeprom_cut = cut;
+        saveConfig(&store, &newer);
+        eeprom_cut = -1;
+        CHECK(loadConfig(&loaded, &restored, &defaults) &&
+                  same_config(&restored, &older) && loaded.sequence == 2,
+              "write torn after %d words: sequence %u restored", cut,
+              loaded.sequence);
+        // the next save goes over the torn record, not the good one
+        saveConfig(&loaded, &newer);
+        CHECK(loaded.slot == 0, "torn write %d: saved over the good record",
+              cut);
+        CHECK(loadConfig(&loaded, &restored, &defaults) &&
+                  same_config(&restored, &newer),
+              "save after torn write %d not restored", cut);
+    }
+}
+
+// Any single bit error in the newest record falls back to the older one
+void test_corruption() {
+    CONFIG_STORE store, loaded;
+    CONFIG older, newer, restored;
+    uint8_t word, bit;
+    erase_eeprom();
+    loadConfig(&store, &restored, &defaults);
+    older = make_config(1);
+    saveConfig(&store, &older);
+    newer = make_config(2);
+    saveConfig(&store, &newer);
+    for (word = 0; word < RECORD_WORDS; word++) {
+        for (bit = 0; bit < 32; bit++) {
+            eeprom[CONFIG_SLOT_WORDS + word] ^= 1u << bit;
+            if (!loadConfig(&loaded, &restored, &defaults) ||
+                !same_config(&restored, &older) || loaded.slot != 0) {
+                CHECK(false, "bit %u of word %u not caught", bit, word);
+            }
+            eeprom[CONFIG_SLOT_WORDS + word] ^= 1u << bit;
+        }
+    }
+    // both bad gives the defaults
+    eeprom[3] ^= 1;
+    eeprom[CONFIG_SLOT_WORDS + 3] ^= 1;
+    CHECK(!loadConfig(&loaded, &restored, &defaults) &&
+              same_config(&restored, &defaults),
+          "two bad records restored");
+}
+
+// A record of another version with a good CRC is not restored
+void test_version() {
+    CONFIG_STORE store, loaded;
+    CONFIG config, restored;
+    uint32_t *record = &eeprom[CONFIG_SLOT_WORDS];
+    erase_eeprom();
+    loadConfig(&store, &config, &defaults);
+    config = make_config(1);
+    saveConfig(&store, &config);
+    config = make_config(2);
+    saveConfig(&store, &config);
+    record[0] += 1;
+    record[RECORD_WORDS - 1] = getConfigCrc(record, RECORD_WORDS - 1);
+    config = make_config(1);
+    CHECK(loadConfig(&loaded, &restored, &defaults) &&
+              same_config(&restored, &config),
+          "record of version %u restored", record[0] & 0xFFFF);
+}
+
+// The newest record wins across the 32-bit sequence wrap
+void test_sequence_wrap() {
+    CONFIG_STORE store, loaded;
+    CONFIG config, restored;
+    erase_eeprom();
+    loadConfig(&store, &config, &defaults);
+    store.sequence = 0xFFFFFFFE;
+    config = make_config(1);
+    saveConfig(&store, &config);
+    config = make_config(2);
+    saveConfig(&store, &config);
+    CHECK(store.sequence == 0, "sequence %u after the wrap", store.sequence);
+    CHECK(loadConfig(&loaded, &restored, &defaults) &&
+              same_config(&restored, &config) && loaded.sequence == 0,
+          "older record won across the wrap");
+}
+
+// A failed write keeps the old record and is not retried for the same
+// settings
+void test_write_failure() {
+    CONFIG_STORE store, loaded;
+    CONFIG older, newer, restored;
+    erase_eeprom();
+    loadConfig(&store, &restored, &defaults);
+    older = make_config(1);
+    saveConfig(&store, &older);
+    newer = make_config(2);
+    eeprom_fail = true;
+    CHECK(!saveConfig(&store, &newer), "failed write reported as saved");
+    eeprom_fail = false;
+    eeprom_writes = 0;
+    CHECK(!saveConfig(&store, &newer) && eeprom_writes == 0,
+          "failed write retried");
+    CHECK(loadConfig(&loaded, &restored, &defaults) &&
+              same_config(&restored, &older),
+          "old record lost after a failed write");
+}
+
+int main(void) {
+    test_blank();
+    test_alternation();
+    test_torn_write();
+    test_corruption();
+    test_version();
+    test_sequence_wrap();
+    test_write_failure();
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
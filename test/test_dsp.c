@@ -0,0 +1,307 @@
+// DSP Library Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Runs every kernel of the portable build of dsp.c and of its DSP_SIMD
+// build (dsp_simd.c, intrinsics emulated) on the same random Q15 and Q31
+// data, in blocks of random size, and requires bit-identical output. The
+// data mixes full scale extremes in so the saturating paths are taken. The
+// FIR is also checked against a direct convolution, and the emulated SSAT
+// against results worked out from its definition.
+//
+//   cc -I.. -o test_dsp test_dsp.c dsp_simd.c ../dsp.c && ./test_dsp
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "check.h"
+#include "dsp.h"
+
+#define TRIALS 2000
+#define MAX_BLOCK 64
+#define MAX_STAGES 4
+#define MAX_TAPS 33
+#define MAX_LOG2_LENGTH 5
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+int failures = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Kernels of the DSP_SIMD build
+void simdInitBiquadQ15(BIQUAD_Q15 *biquad, BIQUAD_Q15_STAGE *stages,
+                       const q15_t *coeffs, uint8_t numStages);
+void simdRunBiquadQ15(BIQUAD_Q15 *biquad, const q15_t *in, q15_t *out,
+                      uint16_t blockSize);
+void simdInitBiquadQ31(BIQUAD_Q31 *biquad, BIQUAD_Q31_STAGE *stages,
+                       const q31_t *coeffs, uint8_t numStages);
+void simdRunBiquadQ31(BIQUAD_Q31 *biquad, const q31_t *in, q31_t *out,
+                      uint16_t blockSize);
+void simdInitFirQ15(FIR_Q15 *fir, const q15_t *coeffs, q15_t *state,
+                    uint16_t numTaps);
+void simdRunFirQ15(FIR_Q15 *fir, const q15_t *in, q15_t *out,
+                   uint16_t blockSize);
+void simdInitMovingAverageQ15(MOVING_AVERAGE_Q15 *average, q15_t *buffer,
+                              uint8_t log2Length);
+void simdRunMovingAverageQ15(MOVING_AVERAGE_Q15 *average, const q15_t *in,
+                             q15_t *out, uint16_t blockSize);
+void simdInitDcBlockerQ15(DC_BLOCKER_Q15 *blocker, q15_t pole);
+void simdRunDcBlockerQ15(DC_BLOCKER_Q15 *blocker, const q15_t *in,
+                         q15_t *out, uint16_t blockSize);
+int simdSsata(int x, int shift, int bits);
+
+uint32_t random32() { return ((uint32_t)rand() << 16) ^ (uint32_t)rand(); }
+
+// One in eight values at full scale
+q15_t random_q15() {
+    switch (random32() & 15) {
+    case 0:
+        return INT16_MIN;
+    case 1:
+        return INT16_MAX;
+    default:
+        return (q15_t)random32();
+    }
+}
+
+// Q31 data keeps the one bit of headroom runBiquadQ31 asks for
+q31_t random_q31_data() { return (q31_t)random32() >> 1; }
+
+q31_t random_q31_coeff() {
+    switch (random32() & 15) {
+    case 0:
+        return INT32_MIN;
+    case 1:
+        return INT32_MAX;
+    default:
+        return (q31_t)random32();
+    }
+}
+
+uint16_t random_block() { return 1 + random32() % MAX_BLOCK; }
+
+void fill_q15(q15_t *data, uint16_t count) {
+    uint16_t i;
+    for (i = 0; i < count; i++) {
+        data[i] = random_q15();
+    }
+}
+
+void test_biquad_q15() {
+    q15_t coeffs[MAX_STAGES * BIQUAD_COEFFS];
+    BIQUAD_Q15_STAGE stages[2][MAX_STAGES];
+    BIQUAD_Q15 biquad[2];
+    q15_t in[MAX_BLOCK], out[2][MAX_BLOCK];
+    uint8_t numStages = 1 + random32() % MAX_STAGES;
+    uint8_t block;
+    fill_q15(coeffs, numStages * BIQUAD_COEFFS);
+    initBiquadQ15(&biquad[0], stages[0], coeffs, numStages);
+    simdInitBiquadQ15(&biquad[1], stages[1], coeffs, numStages);
+    for (block = 0; block < 4; block++) {
+        uint16_t n = random_block();
+        fill_q15(in, n);
+        runBiquadQ15(&biquad[0], in, out[0], n);
+        simdRunBiquadQ15(&biquad[1], in, out[1], n);
+        if (memcmp(out[0], out[1], n * sizeof(q15_t)) != 0) {
+            CHECK(false, "biquad q15, %u stages", numStages);
+            return;
+        }
+    }
+}
+
+void test_biquad_q31() {
+    q31_t coeffs[MAX_STAGES * BIQUAD_COEFFS];
+    BIQUAD_Q31_STAGE stages[2][MAX_STAGES];
+    BIQUAD_Q31 biquad[2];
+    q31_t in[MAX_BLOCK], out[2][MAX_BLOCK];
+    uint8_t numStages = 1 + random32() % MAX_STAGES;
+    uint8_t block;
+    uint16_t i;
+    for (i = 0; i < numStages * BIQUAD_COEFFS; i++) {
+        coeffs[i] = random_q31_coeff();
+    }
+    initBiquadQ31(&biquad[0], stages[0], coeffs, numStages);
+    simdInitBiquadQ31(&biquad[1], stages[1], coeffs, numStages);
+    for (block = 0; block < 4; block++) {
+        uint16_t n = random_block();
+        for (i = 0; i < n; i++) {
+            in[i] = random_q31_data();
+        }
+        runBiquadQ31(&biquad[0], in, out[0], n);
+        simdRunBiquadQ31(&biquad[1], in, out[1], n);
+        if (memcmp(out[0], out[1], n * sizeof(q31_t)) != 0) {
+            CHECK(false, "biquad q31, %u stages", numStages);
+            return;
+        }
+    }
+}
+
+// Odd and even tap counts take different tails in runFirQ15
+void test_fir() {
+    q15_t coeffs[MAX_TAPS];
+    q15_t state[2][MAX_TAPS - 1 + MAX_BLOCK];
+    q15_t history[MAX_TAPS - 1 + 4 * MAX_BLOCK];
+    FIR_Q15 fir[2];
+    q15_t in[MAX_BLOCK], out[2][MAX_BLOCK];
+    uint16_t numTaps = 1 + random32() % MAX_TAPS;
+    uint16_t have = numTaps - 1;
+    uint8_t block;
+    uint16_t i, k;
+    fill_q15(coeffs, numTaps);
+    memset(history, 0, sizeof(history));
+    initFirQ15(&fir[0], coeffs, state[0], numTaps);
+    simdInitFirQ15(&fir[1], coeffs, state[1], numTaps);
+    for (block = 0; block < 4; block++) {
+        uint16_t n = random_block();
+        fill_q15(in, n);
+        runFirQ15(&fir[0], in, out[0], n);
+        simdRunFirQ15(&fir[1], in, out[1], n);
+        if (memcmp(out[0], out[1], n * sizeof(q15_t)) != 0) {
+            CHECK(false, "fir, %u taps", numTaps);
+            return;
+        }
+        // direct convolution over everything fed so far
+        memcpy(&history[have], in, n * sizeof(q15_t));
+        for (i = 0; i < n; i++) {
+            int64_t acc = 0;
+            int32_t y;
+            for (k = 0; k < numTaps; k++) {
+                acc += (int32_t)coeffs[k] * history[have + i - k];
+            }
+            y = (int32_t)((acc + (1 << 14)) >> 15);
+            y = y > INT16_MAX ? INT16_MAX : y < INT16_MIN ? INT16_MIN : y;
+            if (out[0][i] != y) {
+                CHECK(false, "fir, %u taps: %d expected %d", numTaps,
+                      out[0][i], y);
+                return;
+            }
+        }
+        have += n;
+    }
+}
+
+void test_moving_average() {
+    q15_t buffer[2][1 << MAX_LOG2_LENGTH];
+    MOVING_AVERAGE_Q15 average[2];
+    q15_t in[MAX_BLOCK], out[2][MAX_BLOCK];
+    uint8_t log2Length = random32() % (MAX_LOG2_LENGTH + 1);
+    uint8_t block;
+    initMovingAverageQ15(&average[0], buffer[0], log2Length);
+    simdInitMovingAverageQ15(&average[1], buffer[1], log2Length);
+    for (block = 0; block < 4; block++) {
+        uint16_t n = random_block();
+        fill_q15(in, n);
+        runMovingAverageQ15(&average[0], in, out[0], n);
+        simdRunMovingAverageQ15(&average[1], in, out[1], n);
+        if (memcmp(out[0], out[1], n * sizeof(q15_t)) != 0) {
+            CHECK(false, "moving average, length %u", 1 << log2Length);
+            return;
+        }
+    }
+}
+
+void test_dc_blocker() {
+    DC_BLOCKER_Q15 blocker[2];
+    q15_t in[MAX_BLOCK], out[2][MAX_BLOCK];
+    q15_t pole = random_q15();
+    uint8_t block;
+    initDcBlockerQ15(&blocker[0], pole);
+    simdInitDcBlockerQ15(&blocker[1], pole);
+    for (block = 0; block < 4; block++) {
+        uint16_t n = random_block();
+        fill_q15(in, n);
+        runDcBlockerQ15(&blocker[0], in, out[0], n);
+        simdRunDcBlockerQ15(&blocker[1], in, out[1], n);
+        if (memcmp(out[0], out[1], n * sizeof(q15_t)) != 0) {
+            CHECK(false, "dc blocker, pole %d", pole);
+            return;
+        }
+    }
+}
+
+// _ssata shifts right (ASR, rounding down) before it saturates
+void test_ssata() {
+    static const struct {
+        int x, shift, bits, result;
+    } cases[] = {
+        {0x12345, 4, 16, 0x1234},  {-5, 1, 16, -3},
+        {-1, 31, 16, -1},          {INT32_MIN, 31, 16, -1},
+        {INT32_MAX, 8, 16, 32767}, {INT32_MIN, 8, 16, -32768},
+        {70000, 0, 16, 32767},     {-70000, 0, 16, -32768},
+        {32767, 0, 16, 32767},     {-32768, 0, 16, -32768},
+        {200, 0, 8, 127},          {-129, 1, 8, -65},
+    };
+    uint8_t i;
+    int result;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        result = simdSsata(cases[i].x, cases[i].shift, cases[i].bits);
+        CHECK(result == cases[i].result, "_ssata(%d, %d, %d) = %d, not %d",
+              cases[i].x, cases[i].shift, cases[i].bits, result,
+              cases[i].result);
+    }
+}
+
+// Host cost of the portable biquad and FIR; target cycles are in bench
+void time_kernels() {
+    static const q15_t lowpass[BIQUAD_COEFFS] = {1024, 2048, 1024, 24000,
+                                                 -9000};
+    q15_t coeffs[MAX_TAPS], state[MAX_TAPS - 1 + MAX_BLOCK];
+    q15_t in[MAX_BLOCK], out[MAX_BLOCK];
+    BIQUAD_Q15_STAGE stage;
+    BIQUAD_Q15 biquad;
+    FIR_Q15 fir;
+    uint32_t i, blocks = 100000;
+    clock_t start;
+    fill_q15(in, MAX_BLOCK);
+    fill_q15(coeffs, MAX_TAPS);
+    initBiquadQ15(&biquad, &stage, lowpass, 1);
+    initFirQ15(&fir, coeffs, state, 32);
+    start = clock();
+    for (i = 0; i < blocks; i++) {
+        runBiquadQ15(&biquad, in, out, MAX_BLOCK);
+    }
+    printf("runBiquadQ15: %.1f ns per sample\n",
+           (clock() - start) * 1e9 / CLOCKS_PER_SEC / blocks / MAX_BLOCK);
+    start = clock();
+    for (i = 0; i < blocks; i++) {
+        runFirQ15(&fir, in, out, MAX_BLOCK);
+    }
+    printf("runFirQ15 (32 taps): %.1f ns per sample\n",
+           (clock() - start) * 1e9 / CLOCKS_PER_SEC / blocks / MAX_BLOCK);
+}
+
+int main(void) {
+    uint32_t trial;
+    srand(1);
+    test_ssata();
+    for (trial = 0; trial < TRIALS; trial++) {
+        test_biquad_q15();
+        test_biquad_q31();
+        test_fir();
+        test_moving_average();
+        test_dc_blocker();
+    }
+    time_kernels();
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
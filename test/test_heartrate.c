@@ -0,0 +1,168 @@
+// Spectral Heart Rate Estimator Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Feeds the estimator a synthetic PPG waveform at the lock-in output rate
+// for heart rates across the whole search band and checks the reported BPM
+// against the true rate. The waveform has a second harmonic, a DC level, a
+// slow baseline drift and noise, like the demodulated amplitude. The real
+// FFT is also checked against a direct DFT and timed.
+//
+//   cc -I.. -o test_heartrate test_heartrate.c ../heartrate.c ../fft.c -lm
+//   ./test_heartrate
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "check.h"
+#include "dsp.h"
+#include "heartrate.h"
+#include "ppg.h"
+
+#define PI 3.14159265358979
+
+// Allowed error in BPM, a bin is 60 * 25 / 256 = 5.9 BPM wide
+#define BPM_TOLERANCE 1.0
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+int failures = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+double noise() { return (rand() / (double)RAND_MAX - 0.5) * 2.0; }
+
+// Lock-in amplitude (LOCKIN_OUT_Q counts) for time t
+int32_t ppg_sample(double bpm, double t, double phase) {
+    double f = bpm / 60.0;
+    double value = 640.0 + 160.0 * sin(2 * PI * f * t + phase) +
+                   60.0 * sin(4 * PI * f * t + 2 * phase + 1.0) +
+                   40.0 * sin(2 * PI * 0.05 * t) + 8.0 * noise();
+    return (int32_t)lround(value);
+}
+
+// Error of the first estimate after the window fills, worst over phases
+double estimate_error(double bpm) {
+    double worst = 0;
+    uint8_t p;
+    for (p = 0; p < 4; p++) {
+        HEART_RATE hr;
+        uint32_t n = 0;
+        double t;
+        initHeartRate(&hr, PPG_AMPLITUDE_HZ);
+        do {
+            t = (double)n++ / PPG_AMPLITUDE_HZ;
+        } while (!addHeartRateSample(&hr, ppg_sample(bpm, t, p * PI / 2)));
+        if (!hr.valid) {
+            return INFINITY;
+        }
+        if (fabs(hr.bpm - bpm) > worst) {
+            worst = fabs(hr.bpm - bpm);
+        }
+    }
+    return worst;
+}
+
+void test_band() {
+    double bpm, worst = 0;
+    for (bpm = 30; bpm <= 240; bpm += 0.7) {
+        double error = estimate_error(bpm);
+        CHECK(error <= BPM_TOLERANCE, "%.1f BPM off by %.2f", bpm, error);
+        if (error > worst) {
+            worst = error;
+        }
+    }
+    printf("30 to 240 BPM: worst error %.2f BPM\n", worst);
+}
+
+// Noise alone must not give a confident estimate most of the time
+void test_noise() {
+    uint16_t trial, valid = 0;
+    for (trial = 0; trial < 100; trial++) {
+        HEART_RATE hr;
+        initHeartRate(&hr, PPG_AMPLITUDE_HZ);
+        while (!addHeartRateSample(&hr, 640 + lround(40 * noise())))
+            ;
+        valid += hr.valid;
+    }
+    printf("noise only: %u of 100 estimates valid\n", valid);
+    CHECK(valid < 10, "noise gave %u valid estimates", valid);
+}
+
+// Bins 0 < k < N / 2 against a direct DFT of the same input, which the
+// FFT scales by 1 / (N / 2)
+void test_rfft() {
+    q15_t data[FFT_LENGTH];
+    double input[FFT_LENGTH];
+    uint16_t i, k;
+    double worst = 0;
+    for (i = 0; i < FFT_LENGTH; i++) {
+        data[i] = (q15_t)lround(12000 * noise());
+        input[i] = data[i];
+    }
+    runRfftQ15(data);
+    for (k = 1; k < FFT_HALF; k++) {
+        double re = 0, im = 0;
+        int32_t fre, fim;
+        for (i = 0; i < FFT_LENGTH; i++) {
+            re += input[i] * cos(2 * PI * k * i / FFT_LENGTH);
+            im -= input[i] * sin(2 * PI * k * i / FFT_LENGTH);
+        }
+        getRfftBinQ15(data, k, &fre, &fim);
+        re /= FFT_HALF;
+        im /= FFT_HALF;
+        if (hypot(fre - re, fim - im) > worst) {
+            worst = hypot(fre - re, fim - im);
+        }
+    }
+    printf("rfft: worst bin error %.1f counts\n", worst);
+    // rounding in 7 halving stages, a few counts at most
+    CHECK(worst < 8, "rfft bin error %.1f", worst);
+}
+
+// Host cost; the target cycle counts are in the bench command
+void time_rfft() {
+    q15_t data[FFT_LENGTH];
+    uint16_t i;
+    uint32_t r, runs = 200000;
+    clock_t start;
+    for (i = 0; i < FFT_LENGTH; i++) {
+        data[i] = (q15_t)lround(12000 * noise());
+    }
+    start = clock();
+    for (r = 0; r < runs; r++) {
+        runRfftQ15(data);
+        data[r & (FFT_LENGTH - 1)] = (q15_t)r;
+    }
+    printf("runRfftQ15 (%u points): %.2f us\n", FFT_LENGTH,
+           (clock() - start) * 1e6 / CLOCKS_PER_SEC / runs);
+}
+
+int main(void) {
+    srand(1);
+    test_rfft();
+    test_band();
+    test_noise();
+    time_rfft();
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
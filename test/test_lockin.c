@@ -0,0 +1,142 @@
+// Lock-in Demodulator Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Builds the ADC stream the PPG interrupt sees: samples at twice the 1 kHz
+// LED rate, alternating LED on and off, with a pulse modulated LED term on
+// top of room light that flickers at twice the mains frequency, plus noise
+// and 12-bit quantization. The demodulated amplitude must recover the
+// pulse DC and AC levels and reject the flicker.
+//
+//   cc -I.. -o test_lockin test_lockin.c ../lockin.c -lm && ./test_lockin
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "check.h"
+#include "lockin.h"
+#include "ppg.h"
+
+#define SAMPLE_HZ (2 * PPG_LED_HZ)
+#define SECONDS 17
+#define SETTLE_SECONDS 2
+#define PI 3.14159265358979
+
+// Scenario: LED term in ADC counts seen through the finger
+#define LED_DC 40.0
+#define PULSE_HZ 1.2
+#define AMBIENT 1500.0
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+int failures = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+double noise() { return (rand() / (double)RAND_MAX - 0.5) * 4.0; }
+
+// Phototransistor output drops as light rises
+uint16_t adc_sample(double light) {
+    double counts = 3500.0 - light + noise();
+    if (counts < 0) {
+        counts = 0;
+    }
+    if (counts > 4095) {
+        counts = 4095;
+    }
+    return (uint16_t)lround(counts);
+}
+
+// Runs the demodulator over one scenario and projects the output on the
+// pulse frequency; dc and ac come back in ADC counts
+void demodulate(double mainsHz, double flicker, double pulseAc, double *dc,
+                double *ac) {
+    LOCKIN lockin;
+    uint32_t n;
+    uint32_t outputs = 0;
+    double sum = 0, sumSin = 0, sumCos = 0;
+    initLockin(&lockin, PPG_LOCKIN_SHIFT, PPG_LOCKIN_DECIMATION);
+    for (n = 0; n < SECONDS * SAMPLE_HZ; n++) {
+        double t = (double)n / SAMPLE_HZ;
+        bool ledOn = (n & 1) == 0;
+        double light = AMBIENT + flicker * sin(2 * PI * 2 * mainsHz * t);
+        int32_t amplitude;
+        if (ledOn) {
+            light += LED_DC + pulseAc * sin(2 * PI * PULSE_HZ * t);
+        }
+        if (updateLockin(&lockin, adc_sample(light), ledOn, &amplitude) &&
+            t >= SETTLE_SECONDS) {
+            double value = amplitude / (double)(1 << LOCKIN_OUT_Q);
+            sum += value;
+            sumSin += value * sin(2 * PI * PULSE_HZ * t);
+            sumCos += value * cos(2 * PI * PULSE_HZ * t);
+            outputs++;
+        }
+    }
+    *dc = sum / outputs;
+    *ac = 2 * sqrt(sumSin * sumSin + sumCos * sumCos) / outputs;
+}
+
+void test_recovery(double mainsHz) {
+    double dc, ac;
+    demodulate(mainsHz, 800.0, 10.0, &dc, &ac);
+    printf("%2.0f Hz mains: dc %.2f ac %.2f\n", mainsHz, dc, ac);
+    CHECK(fabs(dc - LED_DC) < 0.25, "%.0f Hz dc %.2f", mainsHz, dc);
+    // the two low-pass poles sit near 10 Hz, a few percent loss at 1.2 Hz
+    CHECK(fabs(ac - 10.0) < 0.6, "%.0f Hz ac %.2f", mainsHz, ac);
+}
+
+// Flicker alone, far larger than the LED term, must not leak through
+void test_rejection(double mainsHz) {
+    double dc, ac;
+    demodulate(mainsHz, 1000.0, 0.0, &dc, &ac);
+    printf("%2.0f Hz flicker only: dc %.2f ac %.2f\n", mainsHz, dc, ac);
+    CHECK(fabs(dc - LED_DC) < 0.25, "%.0f Hz flicker dc %.2f", mainsHz, dc);
+    CHECK(ac < 0.2, "%.0f Hz flicker leaks %.2f", mainsHz, ac);
+}
+
+// Host cost per sample, the target cycle count is the bench command
+void time_lockin() {
+    LOCKIN lockin;
+    int32_t amplitude = 0, sum = 0;
+    uint32_t n, samples = 20000000;
+    clock_t start = clock();
+    initLockin(&lockin, PPG_LOCKIN_SHIFT, PPG_LOCKIN_DECIMATION);
+    for (n = 0; n < samples; n++) {
+        if (updateLockin(&lockin, n & 4095, n & 1, &amplitude)) {
+            sum += amplitude;
+        }
+    }
+    printf("updateLockin: %.1f ns per sample (%ld)\n",
+           (clock() - start) * 1e9 / CLOCKS_PER_SEC / samples, (long)sum);
+}
+
+int main(void) {
+    srand(1);
+    test_recovery(50);
+    test_recovery(60);
+    test_rejection(50);
+    test_rejection(60);
+    time_lockin();
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
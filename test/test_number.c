@@ -0,0 +1,303 @@
+// Number Parsing Library Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Differential test of parseInteger against strtoll and of parseFixed
+// against strtod. The inputs are random numbers around the int32_t and
+// Q16.16 limits in decimal and hex, the same with a bad character put in
+// or added as a suffix, and random strings over the characters a number
+// may contain. A table of edge cases and host timings against the C
+// library follow.
+//
+//   cc -I.. -o test_number test_number.c ../number.c -lm && ./test_number
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "check.h"
+#include "number.h"
+
+#define TRIALS 2000000
+#define MAX_LENGTH 24
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+int failures = 0;
+
+const char *status_names[] = {"ok", "empty", "invalid", "overflow"};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint32_t random32() { return ((uint32_t)rand() << 16) ^ (uint32_t)rand(); }
+
+// Expected parseInteger result: the digits up to the first character that
+// is not one are converted by strtoll, so an overflow in them is reported
+// before a bad character after them
+NUMBER_STATUS reference_integer(const char *str, uint8_t length,
+                                int32_t *value) {
+    char body[MAX_LENGTH + 1];
+    const char *digits = "0123456789";
+    bool negative = false;
+    uint8_t i = 0, span;
+    int base = 10;
+    long long magnitude;
+    if (length > 0 && (str[0] == '-' || str[0] == '+')) {
+        negative = str[0] == '-';
+        i = 1;
+    }
+    if (length - i > 2 && str[i] == '0' && (str[i + 1] == 'x' ||
+                                           str[i + 1] == 'X')) {
+        digits = "0123456789abcdefABCDEF";
+        base = 16;
+        i += 2;
+    }
+    if (i == length) {
+        return NUMBER_EMPTY;
+    }
+    memcpy(body, &str[i], length - i);
+    body[length - i] = 0;
+    span = strspn(body, digits);
+    if (span == 0) {
+        return NUMBER_INVALID;
+    }
+    body[span] = 0;
+    errno = 0;
+    magnitude = strtoll(body, NULL, base);
+    if (errno == ERANGE || magnitude > (negative ? 0x80000000LL : INT32_MAX)) {
+        return NUMBER_OVERFLOW;
+    }
+    if (span < length - i) {
+        return NUMBER_INVALID;
+    }
+    *value = (int32_t)(negative ? -magnitude : magnitude);
+    return NUMBER_OK;
+}
+
+// Expected parseFixed result: the grammar is checked here, the value comes
+// from strtod. Inputs keep to 9 fraction digits, so rounding never ties.
+NUMBER_STATUS reference_fixed(const char *str, uint8_t length,
+                              int32_t *value) {
+    char text[MAX_LENGTH + 1];
+    uint8_t i = 0;
+    bool negative = false, point = false, digits = false;
+    uint32_t whole = 0;
+    double scaled;
+    if (length > 0 && (str[0] == '-' || str[0] == '+')) {
+        negative = str[0] == '-';
+        i = 1;
+    }
+    for (; i < length; i++) {
+        if (str[i] == '.' && !point) {
+            point = true;
+        } else if (str[i] < '0' || str[i] > '9') {
+            return NUMBER_INVALID;
+        } else {
+            digits = true;
+            if (!point) {
+                whole = whole * 10 + (str[i] - '0');
+                if (whole > (negative ? 0x8000u : 0x7FFFu)) {
+                    return NUMBER_OVERFLOW;
+                }
+            }
+        }
+    }
+    if (!digits) {
+        return NUMBER_EMPTY;
+    }
+    memcpy(text, str, length);
+    text[length] = 0;
+    scaled = round(strtod(text, NULL) * 65536);
+    if (scaled > INT32_MAX || scaled < INT32_MIN) {
+        return NUMBER_OVERFLOW;
+    }
+    *value = (int32_t)scaled;
+    return NUMBER_OK;
+}
+
+bool compare_integer(const char *str, uint8_t length) {
+    int32_t value = 0x5A5A5A5A, expected = 0x5A5A5A5A;
+    NUMBER_STATUS status = parseInteger(str, length, &value);
+    NUMBER_STATUS want = reference_integer(str, length, &expected);
+    if (status != want || value != expected) {
+        CHECK(false, "parseInteger \"%.*s\": %s %ld, expected %s %ld", length,
+              str, status_names[status], (long)value, status_names[want],
+              (long)expected);
+        return false;
+    }
+    return true;
+}
+
+bool compare_fixed(const char *str, uint8_t length) {
+    int32_t value = 0x5A5A5A5A, expected = 0x5A5A5A5A;
+    NUMBER_STATUS status = parseFixed(str, length, &value);
+    NUMBER_STATUS want = reference_fixed(str, length, &expected);
+    if (status != want || value != expected) {
+        CHECK(false, "parseFixed \"%.*s\": %s %ld, expected %s %ld", length,
+              str, status_names[status], (long)value, status_names[want],
+              (long)expected);
+        return false;
+    }
+    return true;
+}
+
+// Puts a character that does not belong at a random place or at the end
+uint8_t corrupt(char *str, uint8_t length) {
+    static const char bad[] = "xXgG-+. _/:";
+    char c = bad[random32() % (sizeof(bad) - 1)];
+    if (random32() & 1 || length == MAX_LENGTH) {
+        str[random32() % length] = c;
+        return length;
+    }
+    str[length] = c;
+    return length + 1;
+}
+
+void test_integers() {
+    static const char alphabet[] = "0123456789abcdefxX+-";
+    char str[MAX_LENGTH + 2];
+    uint32_t trial;
+    uint8_t length, i;
+    for (trial = 0; trial < TRIALS; trial++) {
+        // around the limits, in decimal and hex
+        long long value = (long long)(int32_t)random32() * (random32() % 3);
+        if (random32() % 4 == 0) {
+            value = (random32() & 1 ? INT32_MAX : INT32_MIN) +
+                    (long long)(random32() % 5) - 2;
+        }
+        if (random32() & 1) {
+            length = snprintf(str, sizeof(str), "%lld", value);
+        } else {
+            length = snprintf(str, sizeof(str), "%s0%c%llx",
+                              value < 0 ? "-" : "", random32() & 1 ? 'x' : 'X',
+                              llabs(value));
+        }
+        if (random32() % 3 == 0) {
+            length = corrupt(str, length);
+        }
+        if (!compare_integer(str, length)) {
+            return;
+        }
+
+        length = random32() % 12;
+        for (i = 0; i < length; i++) {
+            str[i] = alphabet[random32() % (sizeof(alphabet) - 1)];
+        }
+        if (!compare_integer(str, length)) {
+            return;
+        }
+    }
+}
+
+void test_fixed() {
+    static const char alphabet[] = "0123456789.+-";
+    char str[MAX_LENGTH + 2];
+    uint32_t trial;
+    uint8_t length, i;
+    for (trial = 0; trial < TRIALS; trial++) {
+        // whole part past +/-32768 now and then, up to 9 fraction digits
+        double value = ((int32_t)random32() / 2147483648.0) * 33000;
+        length = snprintf(str, sizeof(str), "%.*f", (int)(random32() % 10),
+                          value);
+        if (random32() % 3 == 0) {
+            length = corrupt(str, length);
+        }
+        if (!compare_fixed(str, length)) {
+            return;
+        }
+
+        length = random32() % 10;
+        for (i = 0; i < length; i++) {
+            str[i] = alphabet[random32() % (sizeof(alphabet) - 1)];
+        }
+        if (!compare_fixed(str, length)) {
+            return;
+        }
+    }
+}
+
+void test_edges() {
+    static const char *integers[] = {
+        "",           "-",           "+",           "0x",
+        "0x0",        "-0x80000000", "0x80000000",  "0x7fffffff",
+        "2147483647", "2147483648",  "-2147483648", "-2147483649",
+        "99999999999x", "12 ",       "1-2",         "0x1g",
+        "+-1",        "007",         "0X1F",        "0xFFFFFFFFF"};
+    static const char *fixeds[] = {
+        ".",      "1.",     "-.5",          "+0.999999999999",
+        "1.2.3",  "--1",    "32767.99999",  "32767.999999",
+        "-32768", "32768",  "-32768.00001", "-32768.000001",
+        "40.5",   "40.5x",  "4e1",          "0.0000076"};
+    uint8_t i;
+    for (i = 0; i < sizeof(integers) / sizeof(integers[0]); i++) {
+        compare_integer(integers[i], strlen(integers[i]));
+    }
+    for (i = 0; i < sizeof(fixeds) / sizeof(fixeds[0]); i++) {
+        compare_fixed(fixeds[i], strlen(fixeds[i]));
+    }
+}
+
+// Host cost against the C library; the target cycle count is in bench
+void time_parsers() {
+    static const char *samples[] = {"-12345678", "150", "0x1F", "40.5",
+                                    "-1.25", "30000.125"};
+    volatile int32_t sink;
+    uint32_t i, runs = 5000000;
+    double ours, library;
+    int32_t value;
+    clock_t start = clock();
+    for (i = 0; i < runs; i++) {
+        parseInteger(samples[i % 3], strlen(samples[i % 3]), &value);
+        sink = value;
+    }
+    ours = (clock() - start) * 1e9 / CLOCKS_PER_SEC / runs;
+    start = clock();
+    for (i = 0; i < runs; i++) {
+        sink = strtol(samples[i % 3], NULL, 0);
+    }
+    library = (clock() - start) * 1e9 / CLOCKS_PER_SEC / runs;
+    printf("parseInteger: %.1f ns, strtol %.1f ns\n", ours, library);
+    start = clock();
+    for (i = 0; i < runs; i++) {
+        parseFixed(samples[3 + i % 3], strlen(samples[3 + i % 3]), &value);
+        sink = value;
+    }
+    ours = (clock() - start) * 1e9 / CLOCKS_PER_SEC / runs;
+    start = clock();
+    for (i = 0; i < runs; i++) {
+        sink = (int32_t)(strtod(samples[3 + i % 3], NULL) * 65536);
+    }
+    library = (clock() - start) * 1e9 / CLOCKS_PER_SEC / runs;
+    printf("parseFixed: %.1f ns, strtod %.1f ns\n", ours, library);
+    (void)sink;
+}
+
+int main(void) {
+    srand(1);
+    test_edges();
+    test_integers();
+    test_fixed();
+    time_parsers();
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
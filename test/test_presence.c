@@ -0,0 +1,161 @@
+// Finger Presence Detector Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Runs the detector with the thresholds of the main file. Checks that a
+// finger is taken only after acquireCount hits in a row past the higher
+// threshold with enough light, that a present finger is kept between the
+// two thresholds, that it is reported until lostCount misses in a row, and
+// that a single good reading in between starts the miss count over.
+//
+//   cc -I.. -o test_presence test_presence.c ../presence.c && ./test_presence
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "check.h"
+#include "presence.h"
+
+#define LIGHT 2000  // LED-on reading well above minLight
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const PRESENCE_CONFIG config = {1500, 60, 40, 5, 30};
+int failures = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Feeds count pairs with the given off - on difference, returns the last
+// state
+PRESENCE_STATE feed(PRESENCE *presence, uint16_t on, int16_t difference,
+                    uint16_t count) {
+    PRESENCE_STATE state = presence->state;
+    uint16_t i;
+    for (i = 0; i < count; i++) {
+        state = updatePresence(presence, on, on + difference);
+    }
+    return state;
+}
+
+// Brings a new detector to PRESENT
+void acquire(PRESENCE *presence) {
+    initPresence(presence, &config);
+    feed(presence, LIGHT, config.enterDiff + 1, config.acquireCount);
+}
+
+// acquireCount hits in a row, a miss in between starts over
+void test_acquire() {
+    PRESENCE presence;
+    initPresence(&presence, &config);
+    CHECK(feed(&presence, LIGHT, 100, config.acquireCount - 1) ==
+                  PRESENCE_ACQUIRING &&
+              !isFingerPresent(&presence),
+          "present after %u hits", config.acquireCount - 1);
+    CHECK(feed(&presence, LIGHT, 100, 1) == PRESENCE_PRESENT &&
+              isFingerPresent(&presence),
+          "not present after %u hits", config.acquireCount);
+
+    initPresence(&presence, &config);
+    feed(&presence, LIGHT, 100, config.acquireCount - 1);
+    CHECK(feed(&presence, LIGHT, 0, 1) == PRESENCE_ABSENT,
+          "a miss did not stop acquiring");
+    CHECK(feed(&presence, LIGHT, 100, config.acquireCount - 1) ==
+              PRESENCE_ACQUIRING,
+          "hits before the miss were kept");
+    CHECK(feed(&presence, LIGHT, 100, 1) == PRESENCE_PRESENT,
+          "not present after %u new hits", config.acquireCount);
+}
+
+// Acquiring needs more than enterDiff with the LED-on reading above
+// minLight
+void test_enter() {
+    PRESENCE presence;
+    initPresence(&presence, &config);
+    CHECK(feed(&presence, LIGHT, config.enterDiff, 100) == PRESENCE_ABSENT,
+          "acquired at the enter threshold");
+    CHECK(feed(&presence, LIGHT, config.enterDiff + 1, 1) ==
+              PRESENCE_ACQUIRING,
+          "not acquiring past the enter threshold");
+    initPresence(&presence, &config);
+    CHECK(feed(&presence, config.minLight, 1000, 100) == PRESENCE_ABSENT,
+          "acquired with the LED-on reading at minLight");
+}
+
+// A present finger stays between the thresholds and is lost at exitDiff
+void test_hysteresis() {
+    PRESENCE presence;
+    acquire(&presence);
+    CHECK(feed(&presence, LIGHT, config.exitDiff + 1, 1000) ==
+              PRESENCE_PRESENT,
+          "lost between the thresholds");
+    CHECK(feed(&presence, LIGHT, config.exitDiff, 1) == PRESENCE_LOST,
+          "kept at the exit threshold");
+    acquire(&presence);
+    CHECK(feed(&presence, config.minLight, 1000, 1) == PRESENCE_LOST,
+          "kept with the LED-on reading at minLight");
+}
+
+// Still reported for lostCount - 1 misses, gone on the next
+void test_loss() {
+    PRESENCE presence;
+    acquire(&presence);
+    CHECK(feed(&presence, LIGHT, 0, config.lostCount - 1) == PRESENCE_LOST &&
+              isFingerPresent(&presence),
+          "gone after %u misses", config.lostCount - 1);
+    CHECK(feed(&presence, LIGHT, 0, 1) == PRESENCE_ABSENT &&
+              !isFingerPresent(&presence),
+          "still reported after %u misses", config.lostCount);
+}
+
+// One good reading while LOST restores PRESENT and a full lostCount of
+// misses is needed again
+void test_return() {
+    PRESENCE presence;
+    acquire(&presence);
+    feed(&presence, LIGHT, 0, config.lostCount - 1);
+    CHECK(feed(&presence, LIGHT, config.exitDiff + 1, 1) ==
+              PRESENCE_PRESENT,
+          "finger back above the exit threshold not present");
+    CHECK(feed(&presence, LIGHT, 0, config.lostCount - 1) == PRESENCE_LOST,
+          "miss count not started over");
+    CHECK(feed(&presence, LIGHT, 0, 1) == PRESENCE_ABSENT,
+          "not gone after %u new misses", config.lostCount);
+}
+
+// With lostCount 1 the first miss is the last
+void test_single_miss() {
+    const PRESENCE_CONFIG quick = {1500, 60, 40, 1, 1};
+    PRESENCE presence;
+    initPresence(&presence, &quick);
+    CHECK(feed(&presence, LIGHT, 100, 1) == PRESENCE_PRESENT,
+          "not present after one hit");
+    CHECK(feed(&presence, LIGHT, 0, 1) == PRESENCE_ABSENT,
+          "not gone after one miss");
+}
+
+int main(void) {
+    test_acquire();
+    test_enter();
+    test_hysteresis();
+    test_loss();
+    test_return();
+    test_single_miss();
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
@@ -0,0 +1,165 @@
+// Autocorrelation Respiration Rate Estimator Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Feeds the estimator a synthetic 10 Hz breath signal, as the breath
+// detector passes it on, at rates from 4 to 40 breaths per minute, deep
+// and shallow, with noise and a sharper inhale. Checks the rate, that
+// regular breathing gives a high confidence and noise alone a low one, and
+// that the window sums kept up one sample at a time equal the sums worked
+// out from the history after the indexes have wrapped many times, also
+// for readings clipped at the input limit.
+//
+//   cc -I.. -o test_respiration test_respiration.c ../respiration.c -lm
+//   ./test_respiration
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "check.h"
+#include "respiration.h"
+
+#define PI 3.14159265358979
+#define BREATH_SAMPLE_HZ 10
+#define SECONDS 90
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+int failures = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+double noise() { return (rand() / (double)RAND_MAX - 0.5) * 2.0; }
+
+// Breathing fundamental with a sharper inhale, plus noise
+int32_t breath_signal(double bpm, double amplitude, double noisiness,
+                      double t) {
+    double phase = 2 * PI * bpm / 60.0 * t;
+    double wave = sin(phase) + 0.2 * sin(2 * phase + 0.7);
+    return (int32_t)lround(amplitude * wave + noisiness * noise());
+}
+
+// Runs a signal for SECONDS, false if no estimate was made
+bool run(RESPIRATION *resp, double bpm, double amplitude, double noisiness) {
+    uint32_t n;
+    bool updated = false;
+    initRespiration(resp);
+    for (n = 0; n < SECONDS * BREATH_SAMPLE_HZ; n++) {
+        updated |= addRespirationSample(
+            resp, breath_signal(bpm, amplitude, noisiness,
+                                n / (double)BREATH_SAMPLE_HZ));
+    }
+    return updated;
+}
+
+// Deep and shallow breathing over the whole range, within 3% of the rate
+// and with a confidence above 0.5
+void test_rates() {
+    RESPIRATION resp;
+    double bpm, worst = 0, error;
+    float lowest = 1;
+    for (bpm = 4; bpm <= 40; bpm += 0.5) {
+        CHECK(run(&resp, bpm, 20000, 1000), "no estimate at %.1f", bpm);
+        error = fabs(resp.rate - bpm) / bpm;
+        CHECK(resp.valid && error < 0.03, "%.1f breaths/min read as %.2f",
+              bpm, resp.rate);
+        CHECK(resp.confidence > 0.5f, "confidence %.2f at %.1f",
+              resp.confidence, bpm);
+        if (error > worst) {
+            worst = error;
+        }
+        if (resp.confidence < lowest) {
+            lowest = resp.confidence;
+        }
+        run(&resp, bpm, 200, 10);
+        CHECK(resp.valid && fabs(resp.rate - bpm) / bpm < 0.03 &&
+                  resp.confidence > 0.5f,
+              "shallow %.1f breaths/min read as %.2f, confidence %.2f", bpm,
+              resp.rate, resp.confidence);
+    }
+    printf("rates: worst error %.2f%%, lowest confidence %.2f\n",
+           100 * worst, lowest);
+}
+
+// Noise alone is either not reported or reported with a low confidence
+void test_noise() {
+    RESPIRATION resp;
+    float highest = 0;
+    uint8_t i;
+    for (i = 0; i < 20; i++) {
+        run(&resp, 12, 0, 20000);
+        CHECK(!resp.valid || resp.confidence < 0.5f,
+              "noise reported at %.2f with confidence %.2f", resp.rate,
+              resp.confidence);
+        if (resp.valid && resp.confidence > highest) {
+            highest = resp.confidence;
+        }
+    }
+    printf("noise: highest confidence %.2f\n", highest);
+}
+
+// Sample lag steps before the newest one
+int32_t get_history(const RESPIRATION *resp, uint16_t lag) {
+    return resp->history[(resp->index + 2 * RESP_HISTORY - 1 - lag) %
+                         RESP_HISTORY];
+}
+
+// Every window sum against the sum worked out from the history
+void check_sums(const RESPIRATION *resp, const char *what) {
+    int64_t direct;
+    uint16_t k, n;
+    for (k = 0; k <= RESP_MAX_LAG + 1; k++) {
+        direct = 0;
+        for (n = 0; n < RESP_WINDOW; n++) {
+            direct += (int64_t)get_history(resp, n) * get_history(resp, n + k);
+        }
+        CHECK(resp->corr[k] == direct, "%s: lag %u sum %lld, direct %lld",
+              what, k, (long long)resp->corr[k], (long long)direct);
+    }
+}
+
+// The running sums stay exact over many passes round the history, for
+// ordinary and for clipped readings
+void test_sums() {
+    RESPIRATION resp;
+    uint32_t n;
+    int32_t sample;
+    initRespiration(&resp);
+    for (n = 0; n < 20 * RESP_HISTORY * RESP_DECIMATION; n++) {
+        sample = breath_signal(15, 20000, 5000, n / (double)BREATH_SAMPLE_HZ);
+        addRespirationSample(&resp, sample);
+    }
+    check_sums(&resp, "breathing");
+    for (n = 0; n < 20 * RESP_HISTORY * RESP_DECIMATION; n++) {
+        sample = rand() & 1 ? INT32_MAX / 2 : -INT32_MAX / 2;
+        addRespirationSample(&resp, sample);
+    }
+    check_sums(&resp, "clipped");
+}
+
+int main(void) {
+    srand(1);
+    test_rates();
+    test_noise();
+    test_sums();
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
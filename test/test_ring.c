@@ -0,0 +1,167 @@
+// Ring Buffer Library Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: -
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Checks the full and empty edges of a ring and the wrap of its free-running
+// indexes, then runs a producer and a consumer thread against each other.
+// Items carry a sequence number and its complement, so an item read before
+// it was written, read twice or skipped shows up. A producer that waits for
+// room must deliver every item in order; one that drops items when full, as
+// an interrupt does, must deliver the rest in order and count each drop.
+//
+//   cc -I.. -o test_ring test_ring.c -lpthread && ./test_ring
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "check.h"
+#include "ring.h"
+
+#define RING_SIZE 16
+#define ITEMS 200000
+
+typedef struct _SEQUENCE {
+    uint32_t number;
+    uint32_t check;  // ~number
+} SEQUENCE;
+
+SPSC_RING(SEQUENCE_RING, SequenceRing, SEQUENCE, RING_SIZE)
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+SEQUENCE_RING ring;
+bool dropWhenFull;
+uint32_t dropped;  // items the dropping producer gave up on
+volatile bool produced, consumed;  // for a broken ring not to hang
+int failures = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+SEQUENCE make_item(uint32_t number) {
+    SEQUENCE item;
+    item.number = number;
+    item.check = ~number;
+    return item;
+}
+
+// Fill, overflow and empty a ring whose indexes wrap part way through
+void test_edges(uint32_t start) {
+    SEQUENCE item;
+    uint32_t i;
+    initSequenceRing(&ring);
+    ring.head = ring.tail = start;
+    CHECK(!popSequenceRing(&ring, &item), "empty ring at %08lx popped",
+          (unsigned long)start);
+    for (i = 0; i < RING_SIZE; i++) {
+        CHECK(pushSequenceRing(&ring, make_item(i)),
+              "push %lu of %u at %08lx failed", (unsigned long)i, RING_SIZE,
+              (unsigned long)start);
+    }
+    CHECK(!pushSequenceRing(&ring, make_item(RING_SIZE)) &&
+              ring.overflows == 1,
+          "full ring at %08lx took an item", (unsigned long)start);
+    for (i = 0; i < RING_SIZE; i++) {
+        CHECK(popSequenceRing(&ring, &item) && item.number == i &&
+                  item.check == ~i,
+              "pop %lu at %08lx wrong", (unsigned long)i,
+              (unsigned long)start);
+    }
+    CHECK(!popSequenceRing(&ring, &item), "emptied ring at %08lx popped",
+          (unsigned long)start);
+}
+
+// A dropping producer lets the consumer in now and then, so both full and
+// empty rings are met on a single core. The last item always waits for
+// room, it tells the consumer to stop.
+void *produce(void *unused) {
+    uint32_t i;
+    (void)unused;
+    for (i = 0; i < ITEMS - 1; i++) {
+        while (!pushSequenceRing(&ring, make_item(i)) && !dropWhenFull) {
+            sched_yield();
+        }
+        if (dropWhenFull && i % 64 == 0) {
+            sched_yield();
+        }
+    }
+    dropped = ring.overflows;
+    while (!pushSequenceRing(&ring, make_item(ITEMS - 1)) && !consumed) {
+        sched_yield();
+    }
+    produced = true;
+    return NULL;
+}
+
+// Consume until the last item, or until the producer is done and the ring
+// is empty if the last item got lost, checking each against the one before
+void test_threads(bool drop) {
+    pthread_t producer;
+    SEQUENCE item;
+    uint32_t received = 0, next = 0, torn = 0, order = 0;
+    bool last = false;
+    initSequenceRing(&ring);
+    ring.head = ring.tail = 0xFFFFFFFF - ITEMS / 2;  // wrap on the way
+    dropWhenFull = drop;
+    produced = consumed = false;
+    pthread_create(&producer, NULL, produce, NULL);
+    while (!last) {
+        if (!popSequenceRing(&ring, &item)) {
+            if (produced && ring.head == ring.tail) {
+                break;
+            }
+            sched_yield();
+            continue;
+        }
+        if (item.check != ~item.number) {
+            torn++;
+        }
+        if (drop ? item.number < next : item.number != next) {
+            order++;
+        }
+        next = item.number + 1;
+        last = item.number == ITEMS - 1;
+        received++;
+    }
+    consumed = true;
+    pthread_join(producer, NULL);
+    CHECK(torn == 0, "%lu torn items", (unsigned long)torn);
+    CHECK(order == 0, "%lu items out of order", (unsigned long)order);
+    if (drop) {
+        CHECK(received + dropped == ITEMS,
+              "%lu received and %lu dropped of %u", (unsigned long)received,
+              (unsigned long)dropped, ITEMS);
+    } else {
+        CHECK(received == ITEMS, "%lu received of %u",
+              (unsigned long)received, ITEMS);
+    }
+    printf("%s producer: %lu received, %lu dropped\n",
+           drop ? "dropping" : "waiting", (unsigned long)received,
+           (unsigned long)(drop ? dropped : 0));
+}
+
+int main(void) {
+    test_edges(0);
+    test_edges(0xFFFFFFFF - RING_SIZE / 2);
+    test_threads(false);
+    test_threads(true);
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
@@ -0,0 +1,616 @@
+// Binary RPC Host Client Test
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: host (Linux or another POSIX system with ptys)
+// Target uC:       - (host test)
+// System Clock:    -
+
+// Runs the client against the firmware's RPC server on the other end of a
+// pty. A child process plays the board: server.c answers with its own
+// handler table, behind a port with fixed readings and statistics, the
+// alarm engine watching a steady pulse, a stream paced by the clock and an
+// idle time of IDLE_MS instead of 30 s. Its transmit path holds some
+// answers back so they reach the client out of order:
+//   GET_STATS    held until the next STOP_STREAM answer, then all sent
+//                newest first
+//   SET_ALARM    the first answer is held until the next GET_VITALS answer
+// The test covers raw mode on the pty, a full window of pipelined requests
+// answered out of order, id matching, timeouts, id reuse after 255, a late
+// response after its timeout, decoded readings, stream samples and alarm
+// events, the server rejecting bad limits, streams and opcodes, the server
+// going back to text mode when idle and the preamble bringing it back, and
+// the error once the monitor is gone, with the bytes of the failed request
+// dropped.
+//
+//   cc -I.. -I../host -o test_rpc_client test_rpc_client.c
+//      ../host/rpc_client.c ../rpc.c ../server.c ../alarm.c
+//   ./test_rpc_client
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "alarm.h"
+#include "check.h"
+#include "rpc.h"
+#include "rpc_client.h"
+#include "server.h"
+
+#define MAX_HELD 8
+#define IDLE_MS 1500
+#define PULSE_MS 100  // pulse reading period of the simulated board
+
+// Simulated readings, exact in Q16.16
+#define PULSE 72.5f
+#define SPECTRAL 73.0f
+#define BREATH 12.25f
+#define AUTOCORR 12.5f
+#define CONFIDENCE 0.75f
+#define LIGHT_ON 1000
+#define LIGHT_OFF 200
+#define STRAIN -1234
+#define CAPTURES 4321
+#define HX711_SAMPLES 8765
+
+// One expected answer, the context of a request
+typedef struct _EXPECT {
+    int id;
+    uint8_t opcode;
+    uint8_t status;
+    bool done;
+    uint64_t sentAt;
+    uint64_t doneAt;
+} EXPECT;
+
+typedef struct _SAMPLES {
+    uint32_t count;
+    RPC_READINGS last;
+} SAMPLES;
+
+typedef struct _ALARM_EVENTS {
+    uint32_t count;
+    RPC_ALARM_REPORT last;
+} ALARM_EVENTS;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+int failures = 0;
+uint32_t callbacks = 0;
+int order[RPC_CLIENT_WINDOW];
+uint8_t order_count = 0;
+RPC_READINGS vitals_last;
+SAMPLES samples;
+ALARM_EVENTS alarm_events;
+
+// simulated board, only used in the child
+int board_fd;
+RPC_SERVER server;
+ALARMS alarms;
+const ALARM_RULE rules[2] = {
+    {0, ALARM_LOW, 3, 40 << 16, 3 << 16, 200},
+    {0, ALARM_HIGH, 2, 150 << 16, 5 << 16, 200},
+};
+uint8_t held_stats[MAX_HELD][RPC_MAX_FRAME], held_stats_length[MAX_HELD];
+uint8_t held_alarm[RPC_MAX_FRAME], held_alarm_length = 0;
+uint8_t held_count = 0;
+bool alarm_held_once = false;
+int32_t stream_hz = 0;
+uint32_t next_sample;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint64_t milliseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+void write_board(const uint8_t *bytes, uint8_t length) {
+    if (write(board_fd, bytes, length) != length) {
+        exit(2);
+    }
+}
+
+// Transmit port of the server, holds answers as the header describes
+void send_board(const uint8_t *bytes, uint8_t length) {
+    uint8_t opcode = bytes[3];
+    if (opcode == (RPC_GET_STATS | RPC_RESPONSE) && held_count < MAX_HELD) {
+        memcpy(held_stats[held_count], bytes, length);
+        held_stats_length[held_count++] = length;
+        return;
+    }
+    if (opcode == (RPC_SET_ALARM | RPC_RESPONSE) && !alarm_held_once) {
+        memcpy(held_alarm, bytes, length);
+        held_alarm_length = length;
+        alarm_held_once = true;
+        return;
+    }
+    if (opcode == (RPC_STOP_STREAM | RPC_RESPONSE)) {
+        while (held_count > 0) {
+            held_count--;
+            write_board(held_stats[held_count], held_stats_length[held_count]);
+        }
+    }
+    if (opcode == (RPC_GET_VITALS | RPC_RESPONSE) && held_alarm_length > 0) {
+        write_board(held_alarm, held_alarm_length);
+        held_alarm_length = 0;
+    }
+    write_board(bytes, length);
+}
+
+void get_board_readings(RPC_SERVER_READINGS *readings) {
+    readings->pulseValid = true;
+    readings->pulse = PULSE;
+    readings->spectralValid = true;
+    readings->spectral = SPECTRAL;
+    readings->breath = BREATH;
+    readings->autocorrValid = true;
+    readings->autocorr = AUTOCORR;
+    readings->confidence = CONFIDENCE;
+    readings->lightOn = LIGHT_ON;
+    readings->lightOff = LIGHT_OFF;
+    readings->strain = STRAIN;
+    readings->alarm = isVitalAlarmed(&alarms, 0);
+}
+
+void get_board_stats(RPC_SERVER_STATS *stats) {
+    stats->captures = CAPTURES;
+    stats->samples = HX711_SAMPLES;
+    stats->overflows = 0;
+}
+
+// Only the pulse has rules on this board
+bool set_board_limits(bool pulse, int32_t min, int32_t max) {
+    if (pulse) {
+        setAlarmLimit(&alarms, 0, min);
+        setAlarmLimit(&alarms, 1, max);
+    }
+    return true;
+}
+
+bool start_board_stream(uint8_t fields, int32_t hz) {
+    (void)fields;
+    stream_hz = hz;
+    next_sample = milliseconds();
+    return true;
+}
+
+void stop_board_stream() { stream_hz = 0; }
+
+void report_board_alarm(uint8_t rule, bool active, int32_t value,
+                        uint32_t time) {
+    (void)time;
+    sendRpcAlarm(&server, rule, &rules[rule], active, value);
+}
+
+const RPC_SERVER_PORT board_port = {
+    send_board,       get_board_readings, get_board_stats,
+    set_board_limits, start_board_stream, stop_board_stream,
+};
+
+// The simulated board, the same loop as the firmware's shell and run_rpc()
+// with the clock in ms; exits once a byte arrives on done
+void run_board(int fd, int done) {
+    uint8_t bytes[64];
+    uint32_t now, next_pulse;
+    ssize_t n, i;
+    board_fd = fd;
+    initRpcServer(&server, &board_port, IDLE_MS);
+    initAlarms(&alarms, rules, 2, 1000, report_board_alarm, milliseconds());
+    next_pulse = milliseconds();
+    while (true) {
+        struct pollfd fds[2] = {{fd, POLLIN, 0}, {done, POLLIN, 0}};
+        poll(fds, 2, 1);
+        if (fds[1].revents != 0) {
+            exit(0);
+        }
+        now = milliseconds();
+        n = fds[0].revents & POLLIN ? read(fd, bytes, sizeof(bytes)) : 0;
+        for (i = 0; i < n; i++) {
+            if (server.active) {
+                addRpcServerByte(&server, bytes[i], now);
+            } else if (matchRpcPreamble(&server, bytes[i])) {
+                startRpcServer(&server, now);
+            }
+        }
+        if ((int32_t)(now - next_pulse) >= 0) {
+            addAlarmSample(&alarms, 0, (int32_t)(PULSE * 65536), now);
+            next_pulse += PULSE_MS;
+        }
+        if (server.active && stream_hz != 0 &&
+            (int32_t)(now - next_sample) >= 0) {
+            sendRpcSample(&server);
+            next_sample += 1000 / stream_hz;
+        }
+        checkRpcServerIdle(&server, now);
+        if (!server.active) {
+            stop_board_stream();
+        }
+    }
+}
+
+void on_sample(void *context, const RPC_READINGS *sample) {
+    SAMPLES *received = context;
+    received->count++;
+    received->last = *sample;
+}
+
+void on_alarm(void *context, const RPC_ALARM_REPORT *alarm) {
+    ALARM_EVENTS *received = context;
+    received->count++;
+    received->last = *alarm;
+}
+
+void on_response(void *context, uint8_t status, const RPC_FRAME *response) {
+    EXPECT *expect = context;
+    RPC_READINGS readings;
+    int32_t value;
+    callbacks++;
+    CHECK(!expect->done, "id %d answered twice", expect->id);
+    expect->done = true;
+    expect->doneAt = milliseconds();
+    if (status == RPC_TIMEOUT) {
+        CHECK(response == NULL, "timeout with a frame");
+        CHECK(expect->status == RPC_TIMEOUT, "id %d timed out", expect->id);
+        return;
+    }
+    CHECK(status == expect->status, "id %d opcode %02x status %u",
+          expect->id, expect->opcode, status);
+    CHECK(response->id == expect->id, "id %d got the answer to %d",
+          expect->id, response->id);
+    CHECK(response->opcode == (expect->opcode | RPC_RESPONSE),
+          "id %d got opcode %02x", expect->id, response->opcode);
+    if (status != RPC_OK) {
+        return;
+    }
+    if (expect->opcode == RPC_GET_VITALS) {
+        decodeRpcReadings(response, &readings);
+        vitals_last = readings;
+        CHECK(readings.pulse == PULSE && readings.spectral == SPECTRAL &&
+                  readings.breath == BREATH &&
+                  readings.autocorr == AUTOCORR &&
+                  readings.confidence == CONFIDENCE,
+              "id %d vitals %.2f %.2f %.2f %.2f %.2f", expect->id,
+              readings.pulse, readings.spectral, readings.breath,
+              readings.autocorr, readings.confidence);
+    }
+    if (expect->opcode == RPC_GET_STATS) {
+        CHECK(getRpcValue(response, RPC_CAPTURES, &value) &&
+                  value == CAPTURES,
+              "id %d stats carry %ld captures", expect->id, (long)value);
+        CHECK(getRpcValue(response, RPC_FRAMES, &value) && value > 0,
+              "id %d stats count no frames", expect->id);
+        if (order_count < RPC_CLIENT_WINDOW) {
+            order[order_count++] = response->id;
+        }
+    }
+}
+
+int send_frame(RPC_CLIENT *client, RPC_FRAME *request, EXPECT *expect,
+               uint8_t status) {
+    expect->opcode = request->opcode;
+    expect->status = status;
+    expect->done = false;
+    expect->sentAt = milliseconds();
+    expect->id = sendRpcRequest(client, request, on_response, expect);
+    return expect->id;
+}
+
+int send_expect(RPC_CLIENT *client, uint8_t opcode, EXPECT *expect,
+                uint8_t status) {
+    RPC_FRAME request;
+    initRpcFrame(&request, 0, opcode);
+    return send_frame(client, &request, expect, status);
+}
+
+// Polls until the expectation is met or a deadline, false on a hang up
+bool wait_for(RPC_CLIENT *client, const EXPECT *expect, uint32_t ms) {
+    uint64_t deadline = milliseconds() + ms;
+    while ((expect == NULL || !expect->done) && milliseconds() < deadline) {
+        struct pollfd fds = {client->fd, getRpcClientEvents(client), 0};
+        poll(&fds, 1, 10);
+        if (!pollRpcClient(client)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// One request and its answer, false if it went unanswered
+bool round_trip(RPC_CLIENT *client, RPC_FRAME *request, uint8_t status) {
+    EXPECT expect;
+    if (send_frame(client, request, &expect, status) < 0) {
+        return false;
+    }
+    wait_for(client, &expect, 1000);
+    return expect.done;
+}
+
+// Three held stats and a stop fill the window; the answers come back
+// newest first and each must reach its own callback
+void test_pipelining(RPC_CLIENT *client) {
+    EXPECT stats[3], stop, extra;
+    uint8_t i;
+    for (i = 0; i < 3; i++) {
+        CHECK(send_expect(client, RPC_GET_STATS, &stats[i], RPC_OK) > 0,
+              "stats %u not sent", i);
+    }
+    CHECK(send_expect(client, RPC_STOP_STREAM, &stop, RPC_OK) > 0,
+          "stop not sent");
+    CHECK(send_expect(client, RPC_GET_VITALS, &extra, RPC_OK) == -1,
+          "a fifth request fit the window");
+    wait_for(client, &stop, 1000);
+    CHECK(stop.done, "stop not answered");
+    for (i = 0; i < 3; i++) {
+        CHECK(stats[i].done, "stats %u not answered", i);
+    }
+    CHECK(order_count == 3 && order[0] == stats[2].id &&
+              order[1] == stats[1].id && order[2] == stats[0].id,
+          "answers not taken newest first");
+}
+
+// Ids run 1 to 255 and start over at 1, never 0
+void test_id_wrap(RPC_CLIENT *client) {
+    EXPECT vitals[RPC_CLIENT_WINDOW];
+    int last = 0;
+    uint16_t sent = 0;
+    uint8_t i, wraps = 0;
+    while (sent < 600) {
+        for (i = 0; i < RPC_CLIENT_WINDOW; i++, sent++) {
+            int id = send_expect(client, RPC_GET_VITALS, &vitals[i], RPC_OK);
+            CHECK(id >= 1 && id <= 255, "id %d", id);
+            if (id <= last) {
+                CHECK(last == 255 && id == 1, "id %d after %d", id, last);
+                wraps++;
+            }
+            last = id;
+        }
+        for (i = 0; i < RPC_CLIENT_WINDOW; i++) {
+            wait_for(client, &vitals[i], 1000);
+            CHECK(vitals[i].done, "id %d not answered", vitals[i].id);
+        }
+        if (failures != 0) {
+            return;
+        }
+    }
+    CHECK(wraps == 2, "ids wrapped %u times", wraps);
+}
+
+// An unanswered request times out once; its answer arriving later must not
+// reach any callback or be taken for the next request
+void test_timeout(RPC_CLIENT *client) {
+    EXPECT alarm, vitals;
+    uint32_t before;
+    send_expect(client, RPC_SET_ALARM, &alarm, RPC_TIMEOUT);
+    wait_for(client, &alarm, 2 * RPC_CLIENT_TIMEOUT_MS);
+    CHECK(alarm.done, "no timeout");
+    CHECK(alarm.doneAt - alarm.sentAt >= RPC_CLIENT_TIMEOUT_MS &&
+              alarm.doneAt - alarm.sentAt < RPC_CLIENT_TIMEOUT_MS + 100,
+          "timed out after %lu ms",
+          (unsigned long)(alarm.doneAt - alarm.sentAt));
+    before = callbacks;
+    send_expect(client, RPC_GET_VITALS, &vitals, RPC_OK);
+    wait_for(client, &vitals, 1000);
+    CHECK(vitals.done, "vitals after a late answer not answered");
+    CHECK(callbacks == before + 1, "late answer reached a callback");
+}
+
+// Samples at the requested rate carry the selected readings, and none
+// arrive once the stop is answered
+void test_stream(RPC_CLIENT *client) {
+    uint32_t count;
+    CHECK(requestRpcStream(client, STREAM_ALL, 50, NULL, NULL) > 0,
+          "stream not sent");
+    samples.count = 0;
+    wait_for(client, NULL, 500);
+    count = samples.count;
+    CHECK(count >= 15 && count <= 35, "%lu samples in 0.5 s at 50 Hz",
+          (unsigned long)count);
+    CHECK(samples.last.present == (RPC_READ_PULSE | RPC_READ_RESPIRATION |
+                                   RPC_READ_LIGHT | RPC_READ_STRAIN |
+                                   RPC_READ_ALARM),
+          "sample fields %02x", samples.last.present);
+    CHECK(samples.last.pulse == PULSE && samples.last.breath == BREATH &&
+              samples.last.lightOn == LIGHT_ON &&
+              samples.last.lightOff == LIGHT_OFF &&
+              samples.last.strain == STRAIN && samples.last.alarm == 0,
+          "sample %.2f %.2f %u %u %ld %u", samples.last.pulse,
+          samples.last.breath, samples.last.lightOn, samples.last.lightOff,
+          (long)samples.last.strain, samples.last.alarm);
+    CHECK(requestRpcStreamStop(client, NULL, NULL) > 0, "stop not sent");
+    wait_for(client, NULL, 100);
+    count = samples.count;
+    wait_for(client, NULL, 200);
+    CHECK(samples.count == count, "%lu samples after the stop",
+          (unsigned long)(samples.count - count));
+}
+
+// Limits above the steady pulse trip the low rule once, the defaults
+// clear it again, and the vitals show the alarm bit in between
+void test_alarm_events(RPC_CLIENT *client) {
+    RPC_FRAME request;
+    EXPECT vitals;
+    alarm_events.count = 0;
+    CHECK(requestRpcAlarm(client, 0, 80, 150, NULL, NULL) > 0,
+          "limits not sent");
+    wait_for(client, NULL, 600);
+    CHECK(alarm_events.count == 1, "%lu alarm events after raising the "
+          "low limit", (unsigned long)alarm_events.count);
+    CHECK(alarm_events.last.rule == 0 && alarm_events.last.vital == 0 &&
+              alarm_events.last.kind == ALARM_LOW &&
+              alarm_events.last.priority == 3 && alarm_events.last.active &&
+              alarm_events.last.value == PULSE,
+          "alarm event %u %u %u %u %u %.2f", alarm_events.last.rule,
+          alarm_events.last.vital, alarm_events.last.kind,
+          alarm_events.last.priority, alarm_events.last.active,
+          alarm_events.last.value);
+    initRpcFrame(&request, 0, RPC_GET_VITALS);
+    send_frame(client, &request, &vitals, RPC_OK);
+    wait_for(client, &vitals, 1000);
+    CHECK(vitals.done && vitals_last.alarm == 1,
+          "vitals during an alarm show %u", vitals_last.alarm);
+    CHECK(requestRpcAlarm(client, 0, 40, 150, NULL, NULL) > 0,
+          "limits not sent");
+    wait_for(client, NULL, 600);
+    CHECK(alarm_events.count == 2 && !alarm_events.last.active,
+          "alarm not cleared by the default limits");
+}
+
+// Each bad request is answered with its status and changes nothing
+void test_validation(RPC_CLIENT *client) {
+    static const struct {
+        uint8_t opcode;
+        int32_t channel;  // or fields
+        int32_t min;      // or rate
+        int32_t max;
+        uint8_t status;
+        const char *what;
+    } cases[] = {
+        {RPC_SET_ALARM, 2, 40 << 16, 150 << 16, RPC_BAD_ARGUMENT,
+         "channel 2"},
+        {RPC_SET_ALARM, 0, 150 << 16, 150 << 16, RPC_BAD_ARGUMENT,
+         "min equal to max"},
+        {RPC_SET_ALARM, 0, -1, 150 << 16, RPC_BAD_ARGUMENT, "min below 0"},
+        {RPC_SET_ALARM, 0, 150 << 16, 80 << 16, RPC_BAD_ARGUMENT,
+         "min above max"},
+        {RPC_START_STREAM, 0, 10, 0, RPC_BAD_ARGUMENT, "no fields"},
+        {RPC_START_STREAM, STREAM_ALL + 1, 10, 0, RPC_BAD_ARGUMENT,
+         "unknown field"},
+        {RPC_START_STREAM, 0x101, 10, 0, RPC_BAD_ARGUMENT,
+         "fields past a byte"},
+        {RPC_START_STREAM, STREAM_PULSE, 0, 0, RPC_BAD_ARGUMENT, "0 Hz"},
+        {RPC_START_STREAM, STREAM_PULSE, STREAM_MAX_HZ + 1, 0,
+         RPC_BAD_ARGUMENT, "too fast"},
+        {0, 0, 0, 0, RPC_BAD_OPCODE, "opcode 0"},
+        {RPC_OPCODES, 0, 0, 0, RPC_BAD_OPCODE, "opcode past the table"},
+        {0x7F, 0, 0, 0, RPC_BAD_OPCODE, "the last opcode"},
+    };
+    RPC_FRAME request;
+    uint32_t before_samples = samples.count;
+    uint32_t before_alarms = alarm_events.count;
+    uint8_t i;
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        initRpcFrame(&request, 0, cases[i].opcode);
+        if (cases[i].opcode == RPC_SET_ALARM) {
+            putRpcValue(&request, RPC_CHANNEL, cases[i].channel, 1);
+            putRpcValue(&request, RPC_MIN, cases[i].min, 4);
+            putRpcValue(&request, RPC_MAX, cases[i].max, 4);
+        } else if (cases[i].opcode == RPC_START_STREAM) {
+            putRpcValue(&request, RPC_FIELDS, cases[i].channel, 4);
+            putRpcValue(&request, RPC_RATE, cases[i].min, 1);
+        }
+        CHECK(round_trip(client, &request, cases[i].status),
+              "%s not answered", cases[i].what);
+    }
+    initRpcFrame(&request, 0, RPC_SET_ALARM);
+    putRpcValue(&request, RPC_CHANNEL, 0, 1);
+    putRpcValue(&request, RPC_MIN, 80 << 16, 4);
+    CHECK(round_trip(client, &request, RPC_BAD_ARGUMENT),
+          "limits without a max not answered");
+    wait_for(client, NULL, 400);
+    CHECK(samples.count == before_samples, "a bad stream started");
+    CHECK(alarm_events.count == before_alarms, "bad limits were set");
+}
+
+// A quiet host loses the server: the stream stops and frames go to the
+// text shell unanswered, until the preamble arrives again, here after a
+// false start that the matcher must not lose it to
+void test_idle(RPC_CLIENT *client, int fd) {
+    static const uint8_t false_start[] = {0xA5, 0x5A, 0xC3};
+    EXPECT lost, vitals;
+    uint32_t count;
+    CHECK(requestRpcStream(client, STREAM_PULSE, 20, NULL, NULL) > 0,
+          "stream not sent");
+    wait_for(client, NULL, IDLE_MS + 300);
+    count = samples.count;
+    wait_for(client, NULL, 300);
+    CHECK(count > 0 && samples.count == count,
+          "stream still running after %u ms idle", IDLE_MS + 300);
+    send_expect(client, RPC_GET_VITALS, &lost, RPC_TIMEOUT);
+    wait_for(client, &lost, 2 * RPC_CLIENT_TIMEOUT_MS);
+    CHECK(lost.done, "request to the idle server not timed out");
+    CHECK(write(fd, false_start, sizeof(false_start)) ==
+              sizeof(false_start),
+          "false start not written");
+    CHECK(openRpcClient(client, fd, on_sample, &samples), "reopen failed");
+    setRpcAlarmCallback(client, on_alarm, &alarm_events);
+    send_expect(client, RPC_GET_VITALS, &vitals, RPC_OK);
+    wait_for(client, &vitals, 1000);
+    CHECK(vitals.done, "no answer after the preamble");
+}
+
+// The monitor hangs up after EXIT; sending and polling must then fail
+void test_hang_up(RPC_CLIENT *client, int done, pid_t monitor) {
+    EXPECT exit, after;
+    send_expect(client, RPC_EXIT, &exit, RPC_OK);
+    wait_for(client, &exit, 1000);
+    CHECK(exit.done, "exit not answered");
+    CHECK(write(done, "x", 1) == 1, "monitor not told");
+    waitpid(monitor, NULL, 0);
+    CHECK(send_expect(client, RPC_GET_VITALS, &after, RPC_OK) == -1,
+          "request sent to a closed pty");
+    CHECK(client->txStart == client->txEnd,
+          "failed request left %u bytes queued",
+          client->txEnd - client->txStart);
+    CHECK(!pollRpcClient(client), "poll on a closed pty succeeded");
+}
+
+int main(void) {
+    RPC_CLIENT client;
+    struct termios raw;
+    int master, slave, done[2];
+    pid_t monitor;
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0 ||
+        (slave = open(ptsname(master), O_RDWR | O_NOCTTY)) < 0 ||
+        pipe(done) < 0) {
+        printf("no pty\n");
+        return 1;
+    }
+    monitor = fork();
+    if (monitor == 0) {
+        close(slave);
+        close(done[1]);
+        run_board(master, done[0]);
+    }
+    close(master);
+    close(done[0]);
+
+    CHECK(openRpcClient(&client, slave, on_sample, &samples), "open failed");
+    setRpcAlarmCallback(&client, on_alarm, &alarm_events);
+    CHECK(tcgetattr(slave, &raw) == 0 && !(raw.c_lflag & (ICANON | ECHO)) &&
+              !(raw.c_oflag & OPOST) && !(raw.c_iflag & ICRNL),
+          "pty not in raw mode");
+    test_pipelining(&client);
+    test_id_wrap(&client);
+    test_timeout(&client);
+    test_stream(&client);
+    test_alarm_events(&client);
+    test_validation(&client);
+    test_idle(&client, slave);
+    test_hang_up(&client, done[1], monitor);
+    printf(failures ? "FAILED\n" : "PASSED\n");
+    return failures != 0;
+}
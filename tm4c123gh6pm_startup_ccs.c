@@ -56,8 +56,11 @@ extern uint32_t __STACK_TOP;
 //*****************************************************************************
 // To be added by user
 extern void wideTimer1Isr();
-extern void pulse_check();
-extern void get_breath();
+extern void adc0Ss3Isr();
+extern void hx711DoutIsr();
+extern void hx711ClockIsr();
+extern void stream_isr();
+extern void uart0Isr();
 
 //*****************************************************************************
 //
@@ -86,11 +89,11 @@ void (*const g_pfnVectors[])(void) = {
     IntDefaultHandler,  // The PendSV handler
     IntDefaultHandler,  // The SysTick handler
     IntDefaultHandler,  // GPIO Port A
-    IntDefaultHandler,  // GPIO Port B
+    hx711DoutIsr,       // GPIO Port B
     IntDefaultHandler,  // GPIO Port C
-    IntDefaultHandler,  // GPIO Port D
-    get_breath,         // GPIO Port E
-    IntDefaultHandler,  // UART0 Rx and Tx
+    hx711DoutIsr,       // GPIO Port D
+    hx711DoutIsr,       // GPIO Port E
+    uart0Isr,           // UART0 Rx and Tx
     IntDefaultHandler,  // UART1 Rx and Tx
     IntDefaultHandler,  // SSI0 Rx and Tx
     IntDefaultHandler,  // I2C0 Master and Slave
@@ -102,13 +105,13 @@ void (*const g_pfnVectors[])(void) = {
     IntDefaultHandler,  // ADC Sequence 0
     IntDefaultHandler,  // ADC Sequence 1
     IntDefaultHandler,  // ADC Sequence 2
-    IntDefaultHandler,  // ADC Sequence 3
+    adc0Ss3Isr,         // ADC Sequence 3
     IntDefaultHandler,  // Watchdog timer
     IntDefaultHandler,  // Timer 0 subtimer A
     IntDefaultHandler,  // Timer 0 subtimer B
     IntDefaultHandler,  // Timer 1 subtimer A
     IntDefaultHandler,  // Timer 1 subtimer B
-    IntDefaultHandler,  // Timer 2 subtimer A
+    stream_isr,         // Timer 2 subtimer A
     IntDefaultHandler,  // Timer 2 subtimer B
     IntDefaultHandler,  // Analog Comparator 0
     IntDefaultHandler,  // Analog Comparator 1
@@ -119,7 +122,7 @@ void (*const g_pfnVectors[])(void) = {
     IntDefaultHandler,  // GPIO Port G
     IntDefaultHandler,  // GPIO Port H
     IntDefaultHandler,  // UART2 Rx and Tx
-    IntDefaultHandler,  // SSI1 Rx and Tx
+    hx711ClockIsr,      // SSI1 Rx and Tx
     IntDefaultHandler,  // Timer 3 subtimer A
     IntDefaultHandler,  // Timer 3 subtimer B
     IntDefaultHandler,  // I2C1 Master and Slave
@@ -155,7 +158,7 @@ void (*const g_pfnVectors[])(void) = {
     0,                  // Reserved
     IntDefaultHandler,  // I2C2 Master and Slave
     IntDefaultHandler,  // I2C3 Master and Slave
-    pulse_check,        // Timer 4 subtimer A
+    hx711ClockIsr,      // Timer 4 subtimer A
     IntDefaultHandler,  // Timer 4 subtimer B
     0,                  // Reserved
     0,                  // Reserved
@@ -0,0 +1,97 @@
+// Trace Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Records are time stamped with the Cortex-M4 DWT cycle counter.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "cycles.h"
+#include "trace.h"
+#include "uart0.h"
+
+typedef struct _TRACE_RECORD {
+    uint32_t time;
+    int32_t value;
+    uint8_t category;
+    uint8_t event;
+} TRACE_RECORD;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+#if TRACE_LEVEL != TRACE_OFF
+TRACE_RECORD trace_ring[TRACE_RECORDS];
+uint32_t trace_count = 0;
+#endif
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Store one record, safe to call from any interrupt level
+void traceWrite(uint8_t category, uint8_t event, int32_t value) {
+#if TRACE_LEVEL != TRACE_OFF
+    uint32_t state = _disable_IRQ();
+    TRACE_RECORD *record = &trace_ring[trace_count & (TRACE_RECORDS - 1)];
+    trace_count++;
+    record->time = DWT_CYCCNT;
+    record->value = value;
+    record->category = category;
+    record->event = event;
+    _restore_interrupts(state);
+#endif
+}
+
+// Print and clear the ring, oldest record first. The count is taken and
+// cleared in one step, so records written while printing start a new ring
+// from slot 0; the old records in the slots they reach are skipped.
+void dumpTrace() {
+#if TRACE_LEVEL != TRACE_OFF
+    char str[48];
+    TRACE_RECORD record;
+    uint32_t i, end, skipped = 0;
+    uint32_t state = _disable_IRQ();
+    end = trace_count;
+    trace_count = 0;
+    _restore_interrupts(state);
+    i = end > TRACE_RECORDS ? end - TRACE_RECORDS : 0;
+    for (; i < end; i++) {
+        uint32_t slot = i & (TRACE_RECORDS - 1);
+        bool overwritten;
+        state = _disable_IRQ();
+        overwritten = trace_count > slot;
+        record = trace_ring[slot];
+        _restore_interrupts(state);
+        if (overwritten) {
+            skipped++;
+            continue;
+        }
+        snprintf(str, sizeof(str), "%10lu %02x %3u %ld\n",
+                 (unsigned long)record.time, record.category, record.event,
+                 (long)record.value);
+        putsUart0(str);
+    }
+    if (skipped != 0) {
+        snprintf(str, sizeof(str), "%lu records overwritten\n",
+                 (unsigned long)skipped);
+        putsUart0(str);
+    }
+#else
+    putsUart0("trace disabled\n");
+#endif
+}
@@ -0,0 +1,78 @@
+// Trace Library
+// Jerome Siljan
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    40 MHz
+
+// Trace points are selected at compile time by level and category. A trace
+// point that is not selected, or any trace point with TRACE_LEVEL set to
+// TRACE_OFF, compiles to nothing and its arguments are never evaluated.
+// Selected trace points store a small binary record in a RAM ring; the text
+// is only formatted later by dumpTrace(), outside of any interrupt.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+// Levels
+#define TRACE_OFF 0
+#define TRACE_ERROR 1
+#define TRACE_INFO 2
+#define TRACE_DEBUG 3
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_OFF
+#endif
+
+// Categories
+#define TRACE_PULSE 0x01
+#define TRACE_BREATH 0x02
+#define TRACE_HX711 0x04
+#define TRACE_SHELL 0x08
+#define TRACE_CONFIG 0x10
+#define TRACE_ALARM 0x20
+
+#ifndef TRACE_CATEGORIES
+#define TRACE_CATEGORIES 0xFF
+#endif
+
+// Events
+#define TRACE_BREATH_PEAK 1
+#define TRACE_BREATH_TROUGH 2
+#define TRACE_BREATH_CYCLE 3
+#define TRACE_HX711_SAMPLE 4
+#define TRACE_PULSE_BPM 5
+#define TRACE_CONFIG_START 6
+#define TRACE_CONFIG_RESTORED 7  // value is the record sequence, 0 for defaults
+#define TRACE_CONFIG_SAVED 8
+#define TRACE_ALARM_CHANGE 9  // value is the rule, plus 256 when active
+
+// Records kept, must be a power of 2
+#define TRACE_RECORDS 128
+
+#if TRACE_LEVEL == TRACE_OFF
+#define TRACE(level, category, event, value) ((void)0)
+#else
+#define TRACE(level, category, event, value)                        \
+    do {                                                            \
+        if ((level) <= TRACE_LEVEL && ((category) & TRACE_CATEGORIES)) \
+            traceWrite((category), (event), (int32_t)(value));      \
+    } while (0)
+#endif
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void traceWrite(uint8_t category, uint8_t event, int32_t value);
+void dumpTrace();
+
+#endif
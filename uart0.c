@@ -14,6 +14,10 @@
 //   U0TX (PA1) and U0RX (PA0) are connected to the 2nd controller
 //   The USB on the 2nd controller enumerates to an ICDI interface and a virtual COM port
 
+// Received bytes are moved from the 16 byte hardware FIFO into a RAM ring by
+// the UART0 interrupt, so the main loop may be busy (sending, writing the
+// EEPROM) for longer than the FIFO lasts without losing input.
+
 //-----------------------------------------------------------------------------
 // Device includes, defines, and assembler directives
 //-----------------------------------------------------------------------------
@@ -21,16 +25,22 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "tm4c123gh6pm.h"
+#include "ring.h"
 #include "uart0.h"
 
 // PortA masks
 #define UART_TX_MASK 2
 #define UART_RX_MASK 1
 
+// Bytes received but not yet read
+SPSC_RING(UART0_RX_RING, Uart0Rx, uint8_t, UART0_RX_SIZE)
+
 //-----------------------------------------------------------------------------
 // Global variables
 //-----------------------------------------------------------------------------
 
+UART0_RX_RING uart0Rx;
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
@@ -59,6 +69,20 @@ void initUart0()
     UART0_LCRH_R = UART_LCRH_WLEN_8 | UART_LCRH_FEN;    // configure for 8N1 w/ 16-level FIFO
     UART0_CTL_R = UART_CTL_TXE | UART_CTL_RXE | UART_CTL_UARTEN;
                                                         // enable TX, RX, and module
+
+    // Receive into the ring from the interrupt
+    initUart0Rx(&uart0Rx);
+    UART0_IM_R = UART_IM_RXIM | UART_IM_RTIM;           // interrupt at half full (reset
+                                                        // level) or when bytes wait 32 bits
+    NVIC_EN0_R |= 1 << (INT_UART0 - 16);                // turn-on interrupt 21 (UART0)
+}
+
+// Receive interrupt and receive timeout: empty the FIFO into the ring
+void uart0Isr()
+{
+    UART0_ICR_R = UART_ICR_RXIC | UART_ICR_RTIC;
+    while (!(UART0_FR_R & UART_FR_RXFE))
+        pushUart0Rx(&uart0Rx, UART0_DR_R & 0xFF);     // full ring drops and counts
 }
 
 // Set baud rate as function of instruction cycle frequency
@@ -83,7 +107,7 @@ void putcUart0(char c)
 }
 
 // Blocking function that writes a string when the UART buffer is not full
-void putsUart0(char* str)
+void putsUart0(const char* str)
 {
     uint8_t i = 0;
     while (str[i] != '\0')
@@ -93,12 +117,19 @@ void putsUart0(char* str)
 // Blocking function that returns with serial data once the buffer is not empty
 char getcUart0()
 {
-    while (UART0_FR_R & UART_FR_RXFE);               // wait if uart0 rx fifo empty
-    return UART0_DR_R & 0xFF;                        // get character from fifo
+    uint8_t c;
+    while (!popUart0Rx(&uart0Rx, &c));               // wait if the receive ring is empty
+    return c;
 }
 
 // Returns the status of the receive buffer
 bool kbhitUart0()
 {
-    return !(UART0_FR_R & UART_FR_RXFE);
+    return uart0Rx.head != uart0Rx.tail;
+}
+
+// Bytes dropped because the receive ring was full
+uint32_t getUart0Overflows()
+{
+    return uart0Rx.overflows;
 }
@@ -21,6 +21,9 @@
 #ifndef UART0_H_
 #define UART0_H_
 
+// Receive ring, a power of 2 that holds a full window of RPC frames
+#define UART0_RX_SIZE 512
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
@@ -28,8 +31,10 @@
 void initUart0();
 void setUart0BaudRate(uint32_t baudRate, uint32_t fcyc);
 void putcUart0(char c);
-void putsUart0(char* str);
+void putsUart0(const char* str);
 char getcUart0();
 bool kbhitUart0();
+void uart0Isr();
+uint32_t getUart0Overflows();
 
 #endif